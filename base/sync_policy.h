@@ -0,0 +1,122 @@
+#ifndef LITE_FNDS_SYNC_POLICY_H
+#define LITE_FNDS_SYNC_POLICY_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "traits.h"
+
+/**
+ * Concurrency policies for the lock-free containers.
+ *
+ * thread_safe_policy:  the default, std::atomic members, CAS loops and cache-line isolation.
+ * thread_local_policy: the container never leaves the thread that owns it (e.g. per-core shards),
+ *                      atomics become plain loads and stores and no cache-line padding is added.
+ *
+ * The container API is the same for both policies.
+ */
+
+namespace lite_fnds {
+    struct thread_safe_policy {};
+    struct thread_local_policy {};
+
+    template <typename Policy>
+    struct is_thread_local_policy : std::is_same<Policy, thread_local_policy> {};
+
+    template <typename Policy>
+    constexpr bool is_thread_local_policy_v = is_thread_local_policy<Policy>::value;
+
+    template <typename Policy>
+    struct is_sync_policy : disjunction<
+        std::is_same<Policy, thread_safe_policy>,
+        std::is_same<Policy, thread_local_policy>> {};
+
+    namespace sync_policy_impl {
+        // a std::atomic look-alike for a single thread, memory orders are accepted and ignored.
+        template <typename T>
+        struct plain_atomic {
+            static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+            T v;
+
+            plain_atomic() noexcept = default;
+
+            constexpr plain_atomic(T desired) noexcept
+                : v(desired) {
+            }
+
+            plain_atomic(const plain_atomic&) = delete;
+            plain_atomic& operator=(const plain_atomic&) = delete;
+
+            FORCE_INLINE T load(std::memory_order = std::memory_order_seq_cst) const noexcept {
+                return v;
+            }
+
+            FORCE_INLINE void store(T desired, std::memory_order = std::memory_order_seq_cst) noexcept {
+                v = desired;
+            }
+
+            FORCE_INLINE T exchange(T desired, std::memory_order = std::memory_order_seq_cst) noexcept {
+                T old = v;
+                v = desired;
+                return old;
+            }
+
+            FORCE_INLINE bool compare_exchange_weak(T& expected, T desired,
+                std::memory_order = std::memory_order_seq_cst,
+                std::memory_order = std::memory_order_seq_cst) noexcept {
+                return compare_exchange_strong(expected, desired);
+            }
+
+            FORCE_INLINE bool compare_exchange_strong(T& expected, T desired,
+                std::memory_order = std::memory_order_seq_cst,
+                std::memory_order = std::memory_order_seq_cst) noexcept {
+                if (v == expected) {
+                    v = desired;
+                    return true;
+                }
+                expected = v;
+                return false;
+            }
+
+            template <typename T_ = T, std::enable_if_t<std::is_integral<T_>::value>* = nullptr>
+            FORCE_INLINE T fetch_add(T arg, std::memory_order = std::memory_order_seq_cst) noexcept {
+                T old = v;
+                v += arg;
+                return old;
+            }
+
+            template <typename T_ = T, std::enable_if_t<std::is_integral<T_>::value>* = nullptr>
+            FORCE_INLINE T fetch_sub(T arg, std::memory_order = std::memory_order_seq_cst) noexcept {
+                T old = v;
+                v -= arg;
+                return old;
+            }
+        };
+
+        template <size_t... ns>
+        struct max_of;
+
+        template <size_t n>
+        struct max_of<n> : std::integral_constant<size_t, n> {};
+
+        template <size_t n, size_t m, size_t... ns>
+        struct max_of<n, m, ns...> : max_of<(n > m ? n : m), ns...> {};
+    }
+
+    template <typename T, typename Policy>
+    using policy_atomic_t = std::conditional_t<is_thread_local_policy_v<Policy>,
+        sync_policy_impl::plain_atomic<T>, std::atomic<T>>;
+
+    // alignment for a member holding Ts... : a full cache line when shared between threads,
+    // the natural alignment otherwise. Use it in place of alignas(CACHE_LINE_SIZE) + pad_t.
+    template <typename Policy, typename... Ts>
+    struct policy_alignment : sync_policy_impl::max_of<
+        (is_thread_local_policy_v<Policy> ? size_t{1} : CACHE_LINE_SIZE), alignof(Ts)...> {};
+
+    template <typename Policy, typename... Ts>
+    constexpr size_t policy_alignment_v = policy_alignment<Policy, Ts...>::value;
+}
+
+#endif
@@ -42,6 +42,12 @@
 #endif
 #endif
 
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#  define LFNDS_HAS_COROUTINES 1
+#else
+#  define LFNDS_HAS_COROUTINES 0
+#endif
+
 #if defined(__GNUC__) || defined(__clang__)
 #define FORCE_INLINE inline __attribute__((always_inline))
 #elif defined(_MSC_VER)
@@ -204,6 +210,7 @@ namespace lite_fnds {
     using std::disjunction;
     using std::disjunction_v;
     using std::negation;
+    using std::negation_v;
     using std::is_swappable;
     using std::is_nothrow_swappable;
 #endif
@@ -1,6 +1,7 @@
 #ifndef LITE_FNDS_TYPE_ERASE_BASE_H
 #define LITE_FNDS_TYPE_ERASE_BASE_H
 
+#include <cstring>
 #include <memory>
 #include <new>
 #include <stdexcept>
@@ -41,6 +42,55 @@ namespace lite_fnds {
         return *static_cast<T * const*>(addr);
     }
 
+    // plain static functions rather than lambdas: taking their address is a constant expression
+    // in C++14, so the vtables built from them are constant initialized.
+    template <typename T, bool sbo_enabled>
+    struct erase_ops;
+
+    template <typename T>
+    struct erase_ops<T, true> {
+        static void copy_construct(void *dst, const void *src) {
+            ::new (dst) T(*tr_ptr<T, true>(src));
+        }
+
+        static void move_construct(void *dst, void *src) {
+            new(dst) T(std::move(*tr_ptr<T, true>(src)));
+        }
+
+        static void relocate_by_move(void *dst, void *src) noexcept {
+            auto _src = tr_ptr<T, true>(src);
+            ::new (dst) T(std::move(*_src));
+            _src->~T();
+        }
+
+        static void relocate_by_copy(void *dst, void *src) noexcept {
+            auto _src = tr_ptr<T, true>(src);
+            ::new (dst) T(*_src);
+            _src->~T();
+        }
+
+        static void destroy(void *addr) noexcept {
+            tr_ptr<T, true>(addr)->~T();
+        }
+    };
+
+    template <typename T>
+    struct erase_ops<T, false> {
+        static void copy_construct(void *dst, const void *src) {
+            *static_cast<T **>(dst) = new T(*tr_ptr<T, false>(src));
+        }
+
+        static void move_construct(void *dst, void *src) noexcept {
+            T*& src_ptr = *static_cast<T**>(src);
+            *static_cast<T **>(dst) = src_ptr;
+            src_ptr = nullptr;
+        }
+
+        static void destroy(void *addr) noexcept {
+            delete tr_ptr<T, false>(addr);
+        }
+    };
+
     template <typename T, bool sbo_enabled,
         std::enable_if_t<negation<std::is_copy_constructible<T> >::value>* = nullptr>
     constexpr fn_copy_construct_t *fcopy_construct() noexcept {
@@ -48,19 +98,9 @@ namespace lite_fnds {
     }
 
     template <typename T, bool sbo_enabled,
-        std::enable_if_t<sbo_enabled && std::is_copy_constructible<T>::value>* = nullptr>
-    constexpr fn_copy_construct_t *fcopy_construct() noexcept {
-        return +[](void *dst, const void *src) {
-            ::new (dst) T(*tr_ptr<T, sbo_enabled>(src));
-        };
-    }
-
-    template <typename T, bool sbo_enabled,
-        std::enable_if_t<!sbo_enabled && std::is_copy_constructible<T>::value>* = nullptr>
+        std::enable_if_t<std::is_copy_constructible<T>::value>* = nullptr>
     constexpr fn_copy_construct_t *fcopy_construct() noexcept {
-        return +[](void *dst, const void *src) {
-            *static_cast<T **>(dst) = new T(*tr_ptr<T, sbo_enabled>(src));
-        };
+        return &erase_ops<T, sbo_enabled>::copy_construct;
     }
 
     template <typename T, bool sbo_enabled,
@@ -70,40 +110,21 @@ namespace lite_fnds {
     }
 
     template <typename T, bool sbo_enabled,
-        std::enable_if_t<sbo_enabled && std::is_move_constructible<T>::value >* = nullptr>
-    constexpr fn_move_construct_t *fmove_construct() noexcept {
-        return +[](void *dst, void *src) {
-            new(dst) T(std::move(*tr_ptr<T, sbo_enabled>(src)));
-        };
-    }
-
-    template <typename T, bool sbo_enabled,
-        std::enable_if_t<!sbo_enabled>* = nullptr>
+        std::enable_if_t<!sbo_enabled || std::is_move_constructible<T>::value >* = nullptr>
     constexpr fn_move_construct_t *fmove_construct() noexcept {
-        return +[](void *dst, void *src) {
-            T*& src_ptr = *static_cast<T**>(src);
-            *static_cast<T **>(dst) = src_ptr;
-            src_ptr = nullptr;
-        };
+        return &erase_ops<T, sbo_enabled>::move_construct;
     }
 
+    // a heap stored object is relocated by handing over its pointer
     template <typename T, bool sbo_enabled, std::enable_if_t<!sbo_enabled>* = nullptr>
     constexpr fn_safe_relocate_t *fsafe_relocate() noexcept {
-        return +[](void *dst, void *src) noexcept  {
-            T*& src_ptr = *static_cast<T**>(src);
-            *static_cast<T **>(dst) = src_ptr;
-            src_ptr = nullptr;
-        };
+        return &erase_ops<T, sbo_enabled>::move_construct;
     }
 
     template <typename T, bool sbo_enabled,
         std::enable_if_t<sbo_enabled && std::is_nothrow_move_constructible<T>::value>* = nullptr>
     constexpr fn_safe_relocate_t *fsafe_relocate() noexcept {
-        return +[](void *dst, void *src) noexcept {
-            auto _src = tr_ptr<T, sbo_enabled>(src);
-            ::new (dst) T(std::move(*_src));
-            _src->~T();
-        };
+        return &erase_ops<T, sbo_enabled>::relocate_by_move;
     }
 
     template <typename T, bool sbo_enabled,
@@ -111,27 +132,19 @@ namespace lite_fnds {
             && !std::is_nothrow_move_constructible<T>::value
             && std::is_nothrow_copy_constructible<T>::value >* = nullptr>
     constexpr fn_safe_relocate_t *fsafe_relocate() noexcept {
-        return +[](void *dst, void *src) noexcept {
-            auto _src = tr_ptr<T, sbo_enabled>(src);
-            ::new (dst) T(*_src);
-            _src->~T();
-        };
+        return &erase_ops<T, sbo_enabled>::relocate_by_copy;
     }
 
-    template <typename T, bool sbo_enabled,
-        std::enable_if_t<sbo_enabled>* = nullptr>
+    template <typename T, bool sbo_enabled>
     constexpr fn_destroy_t *fdestroy() noexcept {
-        return +[](void *addr) noexcept {
-            tr_ptr<T, sbo_enabled>(addr)->~T();
-        };
+        return &erase_ops<T, sbo_enabled>::destroy;
     }
 
-    template <typename T, bool sbo_enabled,
-        std::enable_if_t<!sbo_enabled>* = nullptr>
-    constexpr fn_destroy_t *fdestroy() noexcept {
-        return +[](void *addr) noexcept {
-            delete tr_ptr<T, sbo_enabled>(addr);
-        };
+    // a heap stored object is only a pointer, a trivially copyable one in the buffer is just bytes,
+    // both can be moved by copying the buffer.
+    template <typename T, bool sbo_enabled>
+    constexpr bool ftrivially_relocatable() noexcept {
+        return !sbo_enabled || std::is_trivially_copyable<T>::value;
     }
 
     struct basic_vtable {
@@ -139,6 +152,7 @@ namespace lite_fnds {
         fn_move_construct_t *move_construct;
         fn_safe_relocate_t  *safe_relocate;
         fn_destroy_t *destroy;
+        bool trivially_relocatable;
     };
 
     template <typename derived, 
@@ -155,6 +169,29 @@ namespace lite_fnds {
             : _vtable{nullptr} {
         }
 
+        // a constant size, so the copy is a few inlined moves rather than a call into the library.
+        // The bytes past the object are indeterminate, copying them as unsigned char is well defined
+        // but gcc can't tell and warns.
+        FORCE_INLINE static void copy_buffer(unsigned char* dst, const unsigned char* src) noexcept {
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+            std::memcpy(dst, src, buf_size);
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+        }
+
+        // moves the object stored at src (described by vt) to dst, src is left without an object.
+        FORCE_INLINE static void relocate(const basic_vtable* vt, unsigned char* dst, unsigned char* src) noexcept {
+            LIKELY_IF(vt->trivially_relocatable) {
+                copy_buffer(dst, src);
+            } else {
+                vt->safe_relocate(dst, src);
+            }
+        }
+
 #if LFNDS_COMPILER_HAS_EXCEPTIONS
         raw_type_erase_base(const raw_type_erase_base& rhs)
             : _vtable(nullptr) {
@@ -313,23 +350,23 @@ namespace lite_fnds {
             }
 
             if (this->_vtable && !rhs._vtable) {
-                this->_vtable->safe_relocate(rhs._data, this->_data);
+                relocate(this->_vtable, rhs._data, this->_data);
                 rhs._vtable = this->_vtable;
                 this->_vtable = nullptr;
                 return;
             }
 
             if (!this->_vtable && rhs._vtable) {
-                rhs._vtable->safe_relocate(this->_data, rhs._data);
+                relocate(rhs._vtable, this->_data, rhs._data);
                 this->_vtable = rhs._vtable;
                 rhs._vtable = nullptr;
                 return;
             }
 
             alignas(align) unsigned char backup[buf_size];
-            this->_vtable->safe_relocate(backup, this->_data);
-            rhs._vtable->safe_relocate(this->_data, rhs._data);
-            this->_vtable->safe_relocate(rhs._data, backup);
+            relocate(this->_vtable, backup, this->_data);
+            relocate(rhs._vtable, this->_data, rhs._data);
+            relocate(this->_vtable, rhs._data, backup);
 
             using std::swap;
             swap(this->_vtable, rhs._vtable);
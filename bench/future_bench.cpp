@@ -0,0 +1,101 @@
+// future_task (lite_promise) vs std_future_task (std::promise).
+//
+// g++ -std=c++14 -O2 -pthread -I.. future_bench.cpp -o future_bench
+//
+// local:  make the task, take its future, run it wrapped in a task_wrapper_sbo, get the result.
+// remote: the same, the task runs on a second thread while the caller blocks in get().
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+#include "../task/future_task.h"
+#include "../task/task_wrapper.h"
+#include "../utility/concurrent_queues.h"
+
+using namespace lite_fnds;
+
+namespace {
+    int work(int x) noexcept {
+        return x + 1;
+    }
+
+    int value_of(int v) noexcept {
+        return v;
+    }
+
+    template <typename R>
+    int value_of(R&& r) noexcept {
+        return r.value();
+    }
+
+    template <typename Make>
+    double local(size_t n, Make make) {
+        size_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            auto t = make(int(i));
+            auto f = t.get_future();
+            task_wrapper_sbo w(std::move(t));
+            w();
+            sum += value_of(f.get());
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (sum == 0) {
+            std::printf("unexpected sum\n");
+        }
+        return double(ns) / double(n);
+    }
+
+    template <typename Make>
+    double remote(size_t n, Make make) {
+        spsc_queue<task_wrapper_sbo, 64> q;
+        std::atomic<bool> stop { false };
+        std::thread worker([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto t = q.try_pop();
+                if (t.has_value()) {
+                    t.get()();
+                }
+            }
+        });
+
+        size_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            auto t = make(int(i));
+            auto f = t.get_future();
+            q.wait_and_emplace(task_wrapper_sbo(std::move(t)));
+            sum += value_of(f.get());
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        stop.store(true);
+        worker.join();
+        if (sum == 0) {
+            std::printf("unexpected sum\n");
+        }
+        return double(ns) / double(n);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    auto lite = [](int x) {
+        return make_future_task(&work, std::move(x));
+    };
+    auto stdp = [](int x) {
+        return make_std_future_task(&work, std::move(x));
+    };
+
+    std::printf("local  round trip: future_task %7.1f ns, std_future_task %7.1f ns\n", local(n, lite), local(n, stdp));
+    std::printf("remote round trip: future_task %7.1f ns, std_future_task %7.1f ns\n",
+        remote(n / 10, lite), remote(n / 10, stdp));
+    return 0;
+}
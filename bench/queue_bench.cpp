@@ -0,0 +1,76 @@
+// ms_queue (unbounded, hazard pointers) vs mpmc_queue (bounded ring): transfer throughput.
+//
+// g++ -std=c++14 -O2 -pthread -I.. queue_bench.cpp ../memory/hazard_ptr.cpp -o queue_bench
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../utility/concurrent_queues.h"
+#include "../utility/ms_queue.h"
+
+using namespace lite_fnds;
+
+namespace {
+    template <typename Queue>
+    double run(size_t producers, size_t consumers, size_t per_producer) {
+        auto q = std::make_unique<Queue>();
+        const size_t total = producers * per_producer;
+        std::atomic<size_t> popped { 0 };
+        std::atomic<size_t> sink { 0 };
+        std::atomic<bool> go { false };
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                while (!go.load(std::memory_order_acquire)) {
+                }
+                for (size_t i = 0; i < per_producer; ++i) {
+                    q->wait_and_emplace(size_t(i));
+                }
+            });
+        }
+        for (size_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                while (!go.load(std::memory_order_acquire)) {
+                }
+                size_t acc = 0;
+                while (popped.load(std::memory_order_relaxed) < total) {
+                    auto v = q->try_pop();
+                    if (v.has_value()) {
+                        acc += v.get();
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        yield();
+                    }
+                }
+                sink.fetch_add(acc);
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& t : threads) {
+            t.join();
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return double(ns) / double(total);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t per_producer = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+    const size_t shapes[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 8, 1 }, { 1, 8 } };
+    for (auto& s : shapes) {
+        const double ms = run<ms_queue<size_t>>(s[0], s[1], per_producer);
+        const double mpmc = run<mpmc_queue<size_t, 1024>>(s[0], s[1], per_producer);
+        std::printf("%zuP/%zuC: ms_queue %7.1f ns/item, mpmc_queue<1024> %7.1f ns/item\n", s[0], s[1], ms, mpmc);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// epoch_guard vs hazard_ptr: read-side cost and the memory held back by reclamation.
+//
+// g++ -std=c++14 -O2 -pthread -I.. reclaim_bench.cpp ../memory/epoch.cpp ../memory/hazard_ptr.cpp -o reclaim_bench
+//
+// read:   readers load and dereference one shared pointer which a writer keeps replacing,
+//         the cost per read is reported.
+// memory: the peak number of replaced objects not yet freed while that runs.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../memory/epoch.h"
+#include "../memory/hazard_ptr.h"
+
+using namespace lite_fnds;
+
+namespace {
+    std::atomic<long> live { 0 };
+    std::atomic<long> peak { 0 };
+
+    struct object {
+        size_t value;
+
+        explicit object(size_t v) noexcept
+            : value(v) {
+            auto n = live.fetch_add(1, std::memory_order_relaxed) + 1;
+            auto p = peak.load(std::memory_order_relaxed);
+            while (n > p && !peak.compare_exchange_weak(p, n, std::memory_order_relaxed)) {
+            }
+        }
+
+        ~object() {
+            live.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<object*> shared { nullptr };
+
+    struct ebr_scheme {
+        static constexpr const char* name = "epoch_guard";
+
+        static size_t read() noexcept {
+            epoch_guard guard;
+            return shared.load(std::memory_order_acquire)->value;
+        }
+
+        static void retire(object* p) noexcept {
+            ebr_mgr::retire(p);
+        }
+
+        static void sweep() noexcept {
+            ebr_mgr::sweep_and_reclaim();
+        }
+    };
+
+    struct hp_scheme {
+        static constexpr const char* name = "hazard_ptr";
+
+        static size_t read() noexcept {
+            hazard_ptr hp;
+            auto p = hp.acquire_protected(shared);
+            auto v = p->value;
+            hp.unprotect();
+            return v;
+        }
+
+        static void retire(object* p) noexcept {
+            hp_mgr::retire(p);
+        }
+
+        static void sweep() noexcept {
+            hp_mgr::sweep_and_reclaim();
+        }
+    };
+
+    template <typename Scheme>
+    void run(size_t readers, std::chrono::milliseconds duration) {
+        shared.store(new object(0));
+        peak.store(live.load());
+
+        std::atomic<bool> stop { false };
+        std::atomic<size_t> reads { 0 };
+        std::atomic<size_t> sink { 0 };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < readers; ++i) {
+            threads.emplace_back([&] {
+                size_t n = 0, acc = 0;
+                for (; !stop.load(std::memory_order_relaxed); ++n) {
+                    acc += Scheme::read();
+                }
+                reads.fetch_add(n);
+                sink.fetch_add(acc);
+            });
+        }
+
+        size_t writes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (; std::chrono::steady_clock::now() - start < duration; ++writes) {
+            Scheme::retire(shared.exchange(new object(writes), std::memory_order_acq_rel));
+        }
+        stop.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        const long held = peak.load();
+
+        Scheme::retire(shared.exchange(nullptr));
+        for (int i = 0; i < 4; ++i) {
+            Scheme::sweep();
+        }
+
+        std::printf("%-12s readers %zu: %8.2f ns/read (thread time), %zu writes, peak unreclaimed %ld, left %ld\n",
+            Scheme::name, readers, reads.load() ? double(ns) * readers / double(reads.load()) : 0.0,
+            writes, held, live.load());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const auto duration = std::chrono::milliseconds(argc > 1 ? std::atoi(argv[1]) : 500);
+
+    for (size_t readers : { 1, 2, 4 }) {
+        run<ebr_scheme>(readers, duration);
+        run<hp_scheme>(readers, duration);
+    }
+    return 0;
+}
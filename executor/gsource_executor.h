@@ -20,9 +20,10 @@
 #include "../task/task_wrapper.h"
 
 namespace lite_fnds {
-    template <size_t capacity_>
+    // Task is the wrapper type queued, e.g. task_wrapper_sbo2 for pipelines with bigger payloads.
+    template <size_t capacity_, typename Task = task_wrapper_sbo>
     struct gsource_executor {
-        using task_wrapper_t = task_wrapper_sbo;
+        using task_wrapper_t = Task;
         using queue_type = mpsc_queue<task_wrapper_t, capacity_>;
 
         constexpr static size_t capacity = capacity_;
@@ -151,7 +152,7 @@ namespace lite_fnds {
             return 0;
         }
 
-        void dispatch(task_wrapper_sbo&& task) noexcept {
+        void dispatch(task_wrapper_t&& task) noexcept {
             assert(task && "attempting to dispatch an empty task into the executor.");
             if (!task) {
                 return;
@@ -9,6 +9,7 @@
 #endif
 
 #include "../base/inplace_base.h"
+#include "../memory/ref_ptr.h"
 #include "flow_blueprint.h"
 
 /**
@@ -45,7 +46,20 @@ namespace lite_fnds {
         constexpr static size_t N = sizeof...(Ts);
         using storage_t = std::tuple<std::decay_t<Ts>...>;
     private:
-        struct Data {
+        struct Data;
+
+        struct data_delete {
+            void operator()(Data* p) const noexcept {
+                p->~Data();
+#ifdef _WIN32
+                _aligned_free(p);
+#else
+                free(p);
+#endif
+            }
+        };
+
+        struct Data : ref_counted<Data, atomic_ref_count, data_delete> {
             alignas(CACHE_LINE_SIZE) std::atomic<size_t> ready_count;
 
             // Tips: if this is checked very frequently, each flag should be aligned by 64
@@ -60,7 +74,7 @@ namespace lite_fnds {
                 }
             }
 
-            static std::shared_ptr<Data> make_shared() {
+            static ref_ptr<Data> make() {
 #ifndef _WIN32
                 void* _p = nullptr;
                 if (posix_memalign(&_p, CACHE_LINE_SIZE, sizeof(Data)) != 0) {
@@ -86,15 +100,7 @@ namespace lite_fnds {
 
                 new (p.get()) Data();
 
-                return std::shared_ptr<Data>(static_cast<Data*>(p.release()), 
-                    [](Data* p) noexcept {
-                        p->~Data();
-#ifdef _WIN32
-                        _aligned_free(p);
-#else
-                        free(p);
-#endif
-                });
+                return ref_ptr<Data>(static_cast<Data*>(p.release()));
             }
         };
 
@@ -103,12 +109,12 @@ namespace lite_fnds {
         struct delegate {
         private:
             using elem_type = std::tuple_element_t<I, storage_t>;
-            std::shared_ptr<Data> data;
+            ref_ptr<Data> data;
              
         public:
             delegate() = delete;
 
-            explicit delegate(std::shared_ptr<Data> d) noexcept
+            explicit delegate(ref_ptr<Data> d) noexcept
                 : data(std::move(d)) {
             }
 
@@ -144,7 +150,7 @@ namespace lite_fnds {
         };
         
         flow_aggregator() : 
-            data(Data::make_shared()) {
+            data(Data::make()) {
 #if !LFNDS_COMPILER_HAS_EXCEPTIONS
             assert(data && "failed to allocate aggregator data.");
 #endif
@@ -193,7 +199,7 @@ namespace lite_fnds {
             return std::move(this->data->val);
         }
     private:
-        std::shared_ptr<Data> data;
+        ref_ptr<Data> data;
     };
 
     template <typename ... BPs>
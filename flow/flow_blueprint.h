@@ -7,6 +7,7 @@
 #include "../utility/compressed_pair.h"
 #include "../base/traits.h"
 #include "../memory/result_t.h"
+#include "../task/task_wrapper.h"
 
 namespace lite_fnds {
 
@@ -173,12 +174,27 @@ namespace lite_fnds {
         constexpr bool is_calc_node_v = is_calc_node<T>::value;
 
         /// flow control
+        // the task type a control node hands on, P names it through task_type, task_wrapper_sbo otherwise.
+        template <typename P>
+        struct control_task {
+        private:
+            template <typename P_>
+            static auto test(int) -> typename P_::task_type;
+
+            template <typename...>
+            static auto test(...) -> task_wrapper_sbo;
+
+        public:
+            using type = decltype(test<P>(0));
+        };
+
         template <typename I, typename O, typename P>
         struct flow_control_node {
             static constexpr auto kind = flow_node_type::flow_node_control;
             using I_t = I;
             using O_t = O;
             using P_t = std::decay_t<P>;
+            using task_t = typename control_task<P_t>::type;
 
             P_t p;
 
@@ -0,0 +1,206 @@
+#ifndef LITE_FNDS_FLOW_BLUEPRINT_SLOT_H
+#define LITE_FNDS_FLOW_BLUEPRINT_SLOT_H
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include "../memory/hazard_ptr.h"
+#include "../memory/ref_ptr.h"
+#include "flow_runner.h"
+
+/**
+ * Hot-swappable blueprints for long-lived runners.
+ *
+ * auto slot = make_blueprint_slot(make_blueprint<int>() | transform(...) | via(...) | end(...));
+ * auto runner = make_runner(slot);      // the slot must outlive the runners reading it
+ *
+ * runner(42);                           // runs on whatever blueprint is current
+ * slot.store(make_blueprint<int>() | transform(...) | via(...) | end(...));
+ * runner(43);                           // new runs pick up the new blueprint
+ *
+ * A run reads the slot under a hazard pointer, the calc nodes before the first control node use
+ * it without touching the reference count. Only a hop through a control node takes a reference,
+ * so in-flight runs finish on the blueprint they started with, the replaced one is released once
+ * the last of them is done.
+ */
+
+namespace lite_fnds {
+    namespace flow_impl {
+        // a blueprint pointer which starts out borrowed (kept alive by a hazard pointer) and
+        // turns into a counted reference as soon as it is copied into a control node hop.
+        template <typename ref_bp>
+        class pinned_bp_ptr {
+            ref_bp* p_;
+            bool owned_;
+
+        public:
+            pinned_bp_ptr(ref_bp* p, bool owned) noexcept
+                : p_ { p }
+                , owned_ { owned } {
+            }
+
+            pinned_bp_ptr(const pinned_bp_ptr& rhs) noexcept
+                : p_ { rhs.p_ }
+                , owned_ { true } {
+                if (p_) {
+                    p_->add_ref();
+                }
+            }
+
+            pinned_bp_ptr(pinned_bp_ptr&& rhs) noexcept
+                : p_ { rhs.p_ }
+                , owned_ { rhs.owned_ } {
+                rhs.p_ = nullptr;
+                rhs.owned_ = false;
+            }
+
+            pinned_bp_ptr& operator=(const pinned_bp_ptr&) = delete;
+            pinned_bp_ptr& operator=(pinned_bp_ptr&&) = delete;
+
+            ~pinned_bp_ptr() noexcept {
+                if (owned_ && p_) {
+                    p_->release();
+                }
+            }
+
+            FORCE_INLINE ref_bp* operator->() const noexcept {
+                return p_;
+            }
+
+            explicit operator bool() const noexcept {
+                return p_ != nullptr;
+            }
+        };
+    }
+
+    // owns one reference to the current blueprint, a replaced blueprint gives that reference
+    // back through the hazard pointer Domain once no run is reading it anymore.
+    template <typename flow_bp, typename Domain = hp_mgr>
+    class flow_blueprint_slot {
+        static_assert(flow_impl::is_blueprint_v<flow_bp>, "flow_bp must be a flow_blueprint");
+
+    public:
+        using bp_t = flow_bp;
+        using ref_bp_t = flow_impl::ref_blueprint<flow_bp>;
+        using bp_ptr = ref_ptr<ref_bp_t>;
+        using domain_t = Domain;
+
+    private:
+        std::atomic<ref_bp_t*> _p;
+
+        static void retire(ref_bp_t* p) noexcept {
+            if (p) {
+                Domain::retire(p, [](ref_bp_t* rp) noexcept {
+                    rp->release();
+                });
+            }
+        }
+
+        template <typename bp_t_, typename Domain_>
+        friend class flow_slot_runner;
+
+    public:
+        constexpr flow_blueprint_slot() noexcept
+            : _p { nullptr } {
+        }
+
+        explicit flow_blueprint_slot(bp_ptr bp) noexcept
+            : _p { bp.detach() } {
+        }
+
+        explicit flow_blueprint_slot(flow_bp bp)
+            : flow_blueprint_slot(make_ref_blueprint(std::move(bp))) {
+        }
+
+        // runs still in flight hold their own references
+        ~flow_blueprint_slot() noexcept {
+            retire(_p.load(std::memory_order_relaxed));
+        }
+
+        // only while no runner reads either slot
+        flow_blueprint_slot(flow_blueprint_slot&& rhs) noexcept
+            : _p { rhs._p.exchange(nullptr, std::memory_order_relaxed) } {
+        }
+
+        flow_blueprint_slot(const flow_blueprint_slot&) = delete;
+        flow_blueprint_slot& operator=(const flow_blueprint_slot&) = delete;
+        flow_blueprint_slot& operator=(flow_blueprint_slot&&) = delete;
+
+        // the previous blueprint is retired, runs already started keep using it.
+        void store(bp_ptr bp) noexcept {
+            retire(_p.exchange(bp.detach(), std::memory_order_acq_rel));
+        }
+
+        void store(flow_bp bp) {
+            store(make_ref_blueprint(std::move(bp)));
+        }
+
+        // a counted reference to the current blueprint, for use outside of a run.
+        bp_ptr load() noexcept {
+            basic_hazard_ptr<Domain> hp;
+            assert(hp.available() && "flow_blueprint_slot: no hazard slot available");
+            return bp_ptr(hp.acquire_protected(_p));
+        }
+    };
+
+    template <typename flow_bp, typename Domain = hp_mgr>
+    class flow_slot_runner {
+    public:
+        using slot_t = flow_blueprint_slot<flow_bp, Domain>;
+        using bp_t = typename slot_t::bp_t;
+        using I_t = typename bp_t::I_t;
+        using O_t = typename bp_t::O_t;
+        using controller_ptr = flow_controller_ptr;
+
+    private:
+        using ref_bp_t = typename slot_t::ref_bp_t;
+        using pinned_ptr = flow_impl::pinned_bp_ptr<ref_bp_t>;
+        using runner_t = flow_runner<flow_bp, pinned_ptr>;
+
+        slot_t* slot;
+        controller_ptr controller;
+
+    public:
+        flow_slot_runner() = delete;
+
+        explicit flow_slot_runner(slot_t& slot_, controller_ptr ctrl = controller_ptr())
+            : slot(&slot_)
+            , controller(ctrl ? std::move(ctrl) : make_controller()) {
+        }
+
+        controller_ptr get_controller() const noexcept {
+            return controller;
+        }
+
+        template <typename In,
+            std::enable_if_t<std::is_convertible<In, typename I_t::value_type>::value>* = nullptr>
+        void operator()(In&& in) noexcept {
+            basic_hazard_ptr<Domain> hp;
+            assert(hp.available() && "flow_slot_runner: no hazard slot available");
+            ref_bp_t* p = hp.acquire_protected(slot->_p);
+            if (!p) {
+                return;
+            }
+
+            // the blueprint can't be released while hp protects it, the runner borrows it until
+            // the first control node, which copies the pointer and so takes a real reference.
+            runner_t runner(pinned_ptr(p, false), controller);
+            runner(std::forward<In>(in));
+        }
+    };
+
+    template <typename flow_bp>
+    auto make_blueprint_slot(flow_bp bp) {
+        static_assert(flow_impl::is_blueprint_v<flow_bp>, "make_blueprint_slot expects a flow_blueprint");
+        return flow_blueprint_slot<flow_bp>(std::move(bp));
+    }
+
+    template <typename flow_bp, typename Domain>
+    auto make_runner(flow_blueprint_slot<flow_bp, Domain>& slot,
+        flow_controller_ptr ctrl = nullptr) noexcept {
+        return flow_slot_runner<flow_bp, Domain>(slot, std::move(ctrl));
+    }
+}
+
+#endif
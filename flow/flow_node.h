@@ -227,13 +227,13 @@ namespace lite_fnds {
 #endif
 
         // via
-        template <typename Executor>
+        template <typename Executor, typename Task>
         struct via_node {
             template <typename X>
             struct check {
                 template <typename U>
                 static auto detect(int) -> std::integral_constant<bool,
-                    noexcept(std::declval<U&>()->dispatch(std::declval<task_wrapper_sbo>()))>;
+                    noexcept(std::declval<U&>()->dispatch(std::declval<Task>()))>;
 
                 template <typename...>
                 static auto detect(...) -> std::false_type;
@@ -243,22 +243,28 @@ namespace lite_fnds {
 
             static_assert(check<Executor>::value,
                 "Executor must be pointer-like and support "
-                "noexcept exec->dispatch(task_wrapper_sbo).");
+                "noexcept exec->dispatch(Task), Task is task_wrapper_sbo by default.");
 
             Executor e;
 
+            struct dispatcher {
+                using task_type = Task;
+                Executor e;
+
+                void operator()(Task&& task) const noexcept {
+                    e->dispatch(std::move(task));
+                }
+            };
+
             template <typename F_I>
             static auto make(via_node&& node) noexcept {
-                auto wrapper = [e = std::move(node.e)](task_wrapper_sbo&& sbo) noexcept {
-                    e->dispatch(std::move(sbo));
-                };
-                return flow_control_node<F_I, F_I, decltype(wrapper)>(std::move(wrapper));
+                return flow_control_node<F_I, F_I, dispatcher>(dispatcher { std::move(node.e) });
             }
         };
 
-        template <typename I, typename O, typename... Nodes, typename Executor>
-        auto operator|(flow_blueprint<I, O, Nodes...> bp, via_node<Executor> a) {
-            auto node = via_node<Executor>::template make<O>(std::move(a));
+        template <typename I, typename O, typename... Nodes, typename Executor, typename Task>
+        auto operator|(flow_blueprint<I, O, Nodes...> bp, via_node<Executor, Task> a) {
+            auto node = via_node<Executor, Task>::template make<O>(std::move(a));
             return std::move(bp) | std::move(node);
         }
 
@@ -367,10 +373,11 @@ namespace lite_fnds {
 
     // CRITICAL: Max payload size is controlled by the SBO buffer (e.g., 64 bytes).
     // Ensure that the captured data (result_t) does not exceed the remaining buffer space.(OR it will trigger heap alloc)
-    template <typename Executor>
+    // Pick a bigger Task (task_wrapper_sbo2/4) for larger payloads, LFNDS_TASK_NO_HEAP reports the ones which don't fit.
+    template <typename Task = task_wrapper_sbo, typename Executor>
     inline auto via(Executor&& exec) noexcept {
         using E = std::decay_t<Executor>;
-        return flow_impl::via_node<E> { std::forward<Executor>(exec) };
+        return flow_impl::via_node<E, Task> { std::forward<Executor>(exec) };
     }
 
     template <typename F>
@@ -2,6 +2,7 @@
 #define LITE_FNDS_FLOW_RUNNER_H
 
 #include <atomic>
+#include <cassert>
 #include <memory>
 #include <tuple>
 #include <type_traits>
@@ -9,6 +10,7 @@
 #include <stdexcept>
 
 #include "../task/task_wrapper.h"
+#include "../memory/ref_ptr.h"
 #include "flow_blueprint.h"
 
 namespace lite_fnds {
@@ -38,7 +40,7 @@ namespace lite_fnds {
         }
     };
 
-    struct flow_controller {
+    struct flow_controller : ref_counted<flow_controller> {
     private:
         enum class runner_cancel {
             none,
@@ -65,7 +67,60 @@ namespace lite_fnds {
         }
     };
 
+    // replaces the std::shared_ptr<flow_controller> of earlier versions (make_runner, get_controller),
+    // the count lives in the controller, so a shared_ptr owned one can't be passed in.
+    using flow_controller_ptr = ref_ptr<flow_controller>;
+
+    // the receiver of an awaited run's end result (see task/coro.h), out points to the result of the end node.
+    struct flow_completion {
+        void (*on_end)(flow_completion* self, void* out) noexcept;
+    };
+
+    inline flow_controller_ptr make_controller() {
+        return make_ref<flow_controller>();
+    }
+
+    namespace flow_impl {
+        // a blueprint carrying its own reference count, so that a runner (and every via hop)
+        // holds one plain pointer to it instead of a shared_ptr with a separate control block.
+        template <typename flow_bp>
+        struct ref_blueprint : flow_bp, ref_counted<ref_blueprint<flow_bp>> {
+            static_assert(is_blueprint_v<flow_bp>, "flow_bp must be a flow_blueprint");
+
+            explicit ref_blueprint(flow_bp&& bp) noexcept
+                : flow_bp(std::move(bp)) {
+            }
+        };
+
+        // what a runner does with the result of the end node besides running it: nothing ...
+        struct no_completion {
+            template <typename R>
+            void operator()(R&) const noexcept {
+            }
+        };
+
+        // ... or hand it to an awaiter, this one pointer then travels through every via hop.
+        struct await_completion {
+            flow_completion* to;
+
+            template <typename R>
+            void operator()(R& out) const noexcept {
+                to->on_end(to, std::addressof(out));
+            }
+        };
+    }
+
     template <typename flow_bp>
+    auto make_ref_blueprint(flow_bp bp) {
+        static_assert(flow_impl::is_blueprint_v<flow_bp>, "make_ref_blueprint expects a flow_blueprint");
+        return make_ref<flow_impl::ref_blueprint<flow_bp>>(std::move(bp));
+    }
+
+    // bp_ptr_t is any copyable pointer-like type to flow_bp,
+    // e.g. std::shared_ptr<flow_bp> or ref_ptr<flow_impl::ref_blueprint<flow_bp>>.
+    // completion_t is flow_impl::no_completion, or await_completion for an awaited run.
+    template <typename flow_bp, typename bp_ptr_t = std::shared_ptr<flow_bp>,
+        typename completion_t = flow_impl::no_completion>
     struct flow_runner {
         static_assert(flow_impl::is_blueprint_v<flow_bp>, "flow_bp must be a flow_blueprint");
 
@@ -80,17 +135,20 @@ namespace lite_fnds {
         using first_node_t = std::tuple_element_t<0, storage_t>;
         static_assert(flow_impl::is_end_node_v<first_node_t>, "A valid blueprint must end with an end");
 
-        using bp_ptr = std::shared_ptr<bp_t>;
-        using controller_ptr = std::shared_ptr<flow_controller>;
+        using bp_ptr = bp_ptr_t;
+        using controller_ptr = flow_controller_ptr;
     private:
         controller_ptr controller;
         bp_ptr bp;
+        completion_t completion;
     public:
         flow_runner() = delete;
 
-        explicit flow_runner(bp_ptr bp_, controller_ptr ctrl = controller_ptr())
-            : controller(ctrl ? std::move(ctrl) : std::make_shared<flow_controller>())
-              , bp(std::move(bp_)) {
+        // done receives the result of the end node, what it points to has to outlive the run
+        explicit flow_runner(bp_ptr bp_, controller_ptr ctrl = controller_ptr(), completion_t done = completion_t())
+            : controller(ctrl ? std::move(ctrl) : make_controller())
+              , bp(std::move(bp_))
+              , completion(done) {
         }
 
         controller_ptr get_controller() const noexcept {
@@ -101,6 +159,8 @@ namespace lite_fnds {
             std::enable_if_t<std::is_convertible<In, typename I_t::value_type>::value>* = nullptr>
         void operator()(In &&in) noexcept {
             if (!bp) {
+                assert((std::is_same<completion_t, flow_impl::no_completion>::value)
+                    && "flow_runner: an awaited run needs a blueprint");
                 return;
             }
             ipc<node_count - 1>::run(*this, I_t(value_tag, std::forward<In>(in)));
@@ -134,7 +194,8 @@ namespace lite_fnds {
 
             template <typename param_t, size_t I_ = I, std::enable_if_t<I_ == 0>* = nullptr>
             static void run(flow_runner& self, param_t &&param) noexcept {
-                std::get<0>(self.bp->nodes_).f(std::forward<param_t>(param));
+                auto out = std::get<0>(self.bp->nodes_).f(std::forward<param_t>(param));
+                self.completion(out);
             }
         private:
             template <typename node_t, typename param_t, size_t I_ = I, std::enable_if_t<I_ != 0>* = nullptr>
@@ -146,28 +207,57 @@ namespace lite_fnds {
             template <typename node_t, typename param_t, size_t I_ = I, std::enable_if_t<I_ != 0>* = nullptr>
             static void dispatch(std::true_type /*control*/,
                                  node_t& node, flow_runner &self, param_t &&in) noexcept {
-                node.p(task_wrapper_sbo([bp = self.bp,
+                hop(std::is_empty<completion_t>{}, node, self, std::forward<param_t>(in));
+            }
+
+            // a plain run's hop captures no completion at all
+            template <typename node_t, typename param_t>
+            static void hop(std::true_type /*no state*/,
+                            node_t& node, flow_runner &self, param_t &&in) noexcept {
+                using task_t = typename node_t::task_t;
+                node.p(task_t([bp = self.bp,
                                                 controller = self.controller,
                                                 in = std::forward<param_t>(in)]() mutable noexcept {
                     flow_runner next_runner(std::move(bp), std::move(controller));
                     ipc<I - 1>::run(next_runner, std::move(in));
                 }));
             }
+
+            template <typename node_t, typename param_t>
+            static void hop(std::false_type,
+                            node_t& node, flow_runner &self, param_t &&in) noexcept {
+                using task_t = typename node_t::task_t;
+                node.p(task_t([bp = self.bp,
+                                                controller = self.controller,
+                                                completion = self.completion,
+                                                in = std::forward<param_t>(in)]() mutable noexcept {
+                    flow_runner next_runner(std::move(bp), std::move(controller), completion);
+                    ipc<I - 1>::run(next_runner, std::move(in));
+                }));
+            }
         };
     };
 
     template <typename I_t, typename O_t, typename... Nodes>
     auto make_runner(std::shared_ptr<flow_impl::flow_blueprint<I_t, O_t, Nodes...>> bp,
-        std::shared_ptr<flow_controller> ctrl = nullptr) noexcept {
+        flow_controller_ptr ctrl = nullptr) noexcept {
         return flow_runner<flow_impl::flow_blueprint<I_t, O_t, Nodes...>>(std::move(bp), std::move(ctrl));
     }
 
+    template <typename I_t, typename O_t, typename... Nodes>
+    auto make_runner(ref_ptr<flow_impl::ref_blueprint<flow_impl::flow_blueprint<I_t, O_t, Nodes...>>> bp,
+        flow_controller_ptr ctrl = nullptr) noexcept {
+        using bp_t = flow_impl::flow_blueprint<I_t, O_t, Nodes...>;
+        using bp_ptr = ref_ptr<flow_impl::ref_blueprint<bp_t>>;
+        return flow_runner<bp_t, bp_ptr>(std::move(bp), std::move(ctrl));
+    }
+
     // one-short runner.
     namespace fast_runner_impl {
         template <typename flow_bp>
         struct bp_storage {
             static_assert(flow_impl::is_blueprint_v<flow_bp>, "flow_bp must be a flow_blueprint");
-            static_assert(false, "a flat bp storage should have a raw pointer or a unique_ptr or a shared_ptr or a reference.");
+            static_assert(sizeof(flow_bp) == 0, "a flat bp storage should have a raw pointer or a unique_ptr or a shared_ptr or a reference.");
         };
 
         template <typename flow_bp>
@@ -349,7 +439,8 @@ namespace lite_fnds {
             template <typename node_t, typename param_t, size_t I_ = I, std::enable_if_t<I_ != 0>* = nullptr>
             static void dispatch(std::true_type /*control*/,
                                  node_t& node, flow_fast_runner &self, param_t &&in) noexcept {
-                node.p(task_wrapper_sbo([bp = std::move(self.bp),
+                using task_t = typename node_t::task_t;
+                node.p(task_t([bp = std::move(self.bp),
                                          in = std::forward<param_t>(in)]() mutable noexcept {
                     flow_fast_runner next_runner(std::move(bp));
                     ipc<I - 1>::run(next_runner, std::move(in));
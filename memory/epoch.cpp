@@ -0,0 +1,14 @@
+// epoch.cpp
+#include "epoch.h"
+
+namespace lite_fnds {
+	std::atomic<uint64_t> ebr_mgr::global_epoch { 1 };
+	ebr_mgr::record_block ebr_mgr::table;
+	std::atomic<size_t> ebr_mgr::leaked { 0 };
+#ifdef USE_HEAP_ALLOCATED
+	std::atomic<ebr_mgr::retire_list_node*> ebr_mgr::retire_list(nullptr);
+#else
+	static_list<ebr_mgr::retire_list_node, ebr_mgr::retire_list_capacity> ebr_mgr::retire_list;
+	std::atomic<ebr_mgr::overflow_node*> ebr_mgr::overflow(nullptr);
+#endif
+}
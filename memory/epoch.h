@@ -0,0 +1,500 @@
+#ifndef LITE_FNDS_EPOCH_H
+#define LITE_FNDS_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "../utility/callable_wrapper.h"
+#include "../utility/static_list.h"
+
+/**
+ * Epoch based reclamation, the cheap-reader sibling of hazard_ptr.
+ *
+ * {
+ *     epoch_guard guard;                  // one store + one fence per critical section
+ *     auto p = table.load(std::memory_order_acquire);
+ *     use(p);                             // any number of reads, nothing is published per pointer
+ * }
+ * ebr_mgr::retire(old_table);             // freed once every reader has left the epoch it was retired in
+ *
+ * The price is the memory bound: a reader stalled inside a guard holds back everything retired
+ * after it entered, once the shared list is full that backlog spills to the heap until the reader
+ * leaves. Keep hazard_ptr for readers which may block for an unbounded time.
+ */
+
+namespace lite_fnds {
+struct ebr_mgr {
+public:
+    using deleter_t = callable_wrapper<void(void*)>;
+
+    // records per block of the thread table, the table grows by a block at a time.
+    static constexpr size_t records_per_block = 64;
+    // a thread tries to advance the epoch once it has collected this many retired objects.
+    static constexpr size_t retire_threshold = 64;
+    // 0 marks a thread outside of any guard, the global epoch starts at 1.
+    static constexpr uint64_t quiescent = 0;
+
+    struct retired_ptr {
+        void* ptr;
+        deleter_t deleter;
+        uint64_t epoch;
+
+        retired_ptr(const retired_ptr&) = delete;
+        retired_ptr& operator=(const retired_ptr&) = delete;
+
+        retired_ptr(retired_ptr&&) noexcept = default;
+        retired_ptr& operator=(retired_ptr&&) noexcept = default;
+
+        template <typename Deleter>
+        retired_ptr(void* p, Deleter _deleter, uint64_t e)
+            noexcept(std::is_nothrow_constructible<deleter_t, Deleter&&>::value)
+            : ptr(p)
+            , deleter(std::move(_deleter))
+            , epoch(e) {
+        }
+
+        // two advances after retirement every reader that could have seen ptr has left.
+        bool expired(uint64_t global) const noexcept {
+            return epoch + 2 <= global;
+        }
+
+        void reclaim() noexcept {
+            deleter(ptr);
+        }
+    };
+
+    static std::atomic<uint64_t> global_epoch;
+
+    struct record {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> epoch { quiescent };
+        std::atomic<bool> in_use { false };
+    };
+
+    struct record_block {
+        record records[records_per_block];
+        std::atomic<record_block*> next { nullptr };
+
+        record* claim() noexcept {
+            for (auto& r : records) {
+                bool exp = false;
+                if (!r.in_use.load(std::memory_order_relaxed)
+                    && r.in_use.compare_exchange_strong(exp, true,
+                        std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return &r;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // blocks are never unlinked, so a scan never waits for a thread to register.
+    static record_block table;
+
+    static record_block* new_block() noexcept {
+        void* p = nullptr;
+#ifdef _WIN32
+        p = _aligned_malloc(sizeof(record_block), CACHE_LINE_SIZE);
+#else
+        if (posix_memalign(&p, CACHE_LINE_SIZE, sizeof(record_block)) != 0) {
+            p = nullptr;
+        }
+#endif
+        return p ? new (p) record_block() : nullptr;
+    }
+
+    static void delete_block(record_block* block) noexcept {
+        block->~record_block();
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        free(block);
+#endif
+    }
+
+    static record* acquire_record() noexcept {
+        record_block* block = &table;
+        for (;;) {
+            if (auto r = block->claim()) {
+                return r;
+            }
+
+            auto nxt = block->next.load(std::memory_order_acquire);
+            if (nxt) {
+                block = nxt;
+                continue;
+            }
+
+            auto fresh = new_block();
+            if (!fresh) {
+                return nullptr;
+            }
+
+            auto r = fresh->claim();
+            if (block->next.compare_exchange_strong(nxt, fresh,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return r;
+            }
+
+            delete_block(fresh);
+            block = nxt;
+        }
+    }
+
+    static void release_record(record* r) noexcept {
+        r->epoch.store(quiescent, std::memory_order_release);
+        r->in_use.store(false, std::memory_order_release);
+    }
+
+    // moves the global epoch forward if every thread inside a guard has observed the current one.
+    static uint64_t try_advance() noexcept {
+        auto e = global_epoch.load(std::memory_order_acquire);
+        // pairs with the fence in epoch_guard, a reader which is not seen here sees the unlinks before it.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        for (auto block = &table; block; block = block->next.load(std::memory_order_acquire)) {
+            for (auto& r : block->records) {
+                // acquire: a reader's exit happens before whatever is freed on the strength of this scan
+                auto re = r.epoch.load(std::memory_order_acquire);
+                if (re != quiescent && re != e) {
+                    return e;
+                }
+            }
+        }
+
+        if (global_epoch.compare_exchange_strong(e, e + 1,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return e + 1;
+        }
+        return e;
+    }
+
+#ifdef USE_HEAP_ALLOCATED
+    struct retire_list_node : retired_ptr {
+        retire_list_node* next = nullptr;
+
+        using retired_ptr::retired_ptr;
+    };
+
+    static std::atomic<retire_list_node*> retire_list;
+
+    static void append_to_retire_list(retire_list_node* node) noexcept {
+        auto old_head = retire_list.load(std::memory_order_relaxed);
+        do {
+            node->next = old_head;
+        } while (!retire_list.compare_exchange_weak(old_head, node,
+            std::memory_order_release, std::memory_order_acquire));
+    }
+
+    static bool push_orphan(retired_ptr&& r) noexcept {
+        auto node = new (std::nothrow) retire_list_node(r.ptr, std::move(r.deleter), r.epoch);
+        if (!node) {
+            return false;
+        }
+        append_to_retire_list(node);
+        return true;
+    }
+
+    // the list itself is unbounded, there is nothing to spill into.
+    static bool spill(retired_ptr&&) noexcept {
+        return false;
+    }
+
+    static void reclaim_orphans(uint64_t global) noexcept {
+        auto list = retire_list.exchange(nullptr, std::memory_order_acq_rel);
+        for (auto p = list; p;) {
+            auto nxt = p->next;
+            if (p->expired(global)) {
+                p->reclaim();
+                delete p;
+            } else {
+                append_to_retire_list(p);
+            }
+            p = nxt;
+        }
+    }
+#else
+    using retire_list_node = retired_ptr;
+
+    static constexpr size_t retire_list_capacity = 256;
+    static constexpr size_t retire_list_kept = 64;
+    static static_list<retire_list_node, retire_list_capacity> retire_list;
+
+    // the spill-over of the static list, a reader stalled inside a guard must not turn retire into a leak.
+    struct overflow_node : retired_ptr {
+        overflow_node* next = nullptr;
+
+        using retired_ptr::retired_ptr;
+    };
+
+    static std::atomic<overflow_node*> overflow;
+
+    static void append_to_overflow(overflow_node* node) noexcept {
+        auto old_head = overflow.load(std::memory_order_relaxed);
+        do {
+            node->next = old_head;
+        } while (!overflow.compare_exchange_weak(old_head, node,
+            std::memory_order_release, std::memory_order_acquire));
+    }
+
+    static bool push_orphan(retired_ptr&& r) noexcept {
+        return retire_list.emplace(std::move(r));
+    }
+
+    static bool spill(retired_ptr&& r) noexcept {
+        auto node = new (std::nothrow) overflow_node(r.ptr, std::move(r.deleter), r.epoch);
+        if (!node) {
+            return false;
+        }
+        append_to_overflow(node);
+        return true;
+    }
+
+    // an entry taken off the static list goes back, or to the heap if other threads refilled it meanwhile.
+    static void keep(retired_ptr&& r) noexcept {
+        UNLIKELY_IF(!retire_list.emplace(std::move(r)) && !spill(std::move(r))) {
+            leaked.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // the young spilled entries move back into the static list while it has room.
+    static void reclaim_overflow(uint64_t global) noexcept {
+        auto list = overflow.exchange(nullptr, std::memory_order_acq_rel);
+        for (auto p = list; p;) {
+            auto nxt = p->next;
+            if (p->expired(global)) {
+                p->reclaim();
+                delete p;
+            } else if (retire_list.emplace(std::move(*p))) {
+                delete p;
+            } else {
+                append_to_overflow(p);
+            }
+            p = nxt;
+        }
+    }
+
+    static void reclaim_orphans(uint64_t global) noexcept {
+        // the entries too young for this round, pushed back once the list has been walked.
+        raw_inplace_storage_base<retire_list_node> kept[retire_list_kept];
+        size_t n_kept = 0;
+
+        for (size_t n = retire_list_capacity; n; --n) {
+            inplace_t<retire_list_node> node = retire_list.pop();
+            if (!node.has_value()) {
+                break;
+            }
+
+            if (node.get().expired(global)) {
+                node.get().reclaim();
+            } else if (n_kept < retire_list_kept) {
+                kept[n_kept++].construct(node.steal());
+            } else {
+                keep(node.steal());
+            }
+        }
+
+        for (size_t i = 0; i < n_kept; ++i) {
+            keep(std::move(*kept[i].ptr()));
+            kept[i].destroy();
+        }
+
+        UNLIKELY_IF(overflow.load(std::memory_order_acquire)) {
+            reclaim_overflow(global);
+        }
+    }
+#endif
+
+    // objects that are never reclaimed because no memory was left to keep them in.
+    static std::atomic<size_t> leaked;
+
+    static size_t leaked_count() noexcept {
+        return leaked.load(std::memory_order_relaxed);
+    }
+
+    // hands a retired object over to the shared list. A full list is helped along first, an entry
+    // expires two advances after its retirement; if a stalled reader holds the epoch back, the
+    // object goes to the heap and only an allocation failure leaks it.
+    static void offload(retired_ptr&& r) noexcept {
+        LIKELY_IF(push_orphan(std::move(r))) {
+            return;
+        }
+
+        try_advance();
+        reclaim_orphans(try_advance());
+
+        UNLIKELY_IF(!push_orphan(std::move(r)) && !spill(std::move(r))) {
+            leaked.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // per thread: the record published to reclaimers, the guard nesting depth and the retired objects.
+    // Retired objects are appended in epoch order, so the expired ones are always a prefix.
+    struct thread_state {
+        record* rec = nullptr;
+        size_t depth = 0;
+
+        raw_inplace_storage_base<retired_ptr> nodes[retire_threshold];
+        size_t count = 0;
+        bool reclaiming = false;
+
+        thread_state() noexcept = default;
+        thread_state(const thread_state&) = delete;
+        thread_state& operator=(const thread_state&) = delete;
+
+        // the thread is gone, whatever is not expired yet moves to the shared list.
+        ~thread_state() noexcept {
+            if (rec) {
+                release_record(rec);
+                rec = nullptr;
+            }
+
+            reclaim(try_advance());
+            for (size_t i = 0; i < count; ++i) {
+                offload(std::move(*nodes[i].ptr()));
+                nodes[i].destroy();
+            }
+            count = 0;
+        }
+
+        bool full() const noexcept {
+            return count == retire_threshold;
+        }
+
+        void push(retired_ptr&& r) noexcept {
+            nodes[count++].construct(std::move(r));
+        }
+
+        // a deleter may retire further objects while this runs, they are appended behind the scanned range.
+        void reclaim(uint64_t global) noexcept {
+            reclaiming = true;
+            const size_t n = count;
+            size_t done = 0;
+            while (done < n && nodes[done].ptr()->expired(global)) {
+                nodes[done].ptr()->reclaim();
+                nodes[done].destroy();
+                ++done;
+            }
+
+            UNLIKELY_IF(done) {
+                size_t kept = 0;
+                for (size_t i = done; i < count; ++i, ++kept) {
+                    nodes[kept].construct(std::move(*nodes[i].ptr()));
+                    nodes[i].destroy();
+                }
+                count = kept;
+            }
+            reclaiming = false;
+        }
+
+        // keeps at least half of the buffer free, so a stalled reader never stalls retire.
+        void shed() noexcept {
+            const size_t keep = retire_threshold >> 1;
+            UNLIKELY_IF(count <= keep) {
+                return;
+            }
+
+            const size_t moved = count - keep;
+            for (size_t i = 0; i < moved; ++i) {
+                offload(std::move(*nodes[i].ptr()));
+                nodes[i].destroy();
+            }
+            for (size_t i = moved; i < count; ++i) {
+                nodes[i - moved].construct(std::move(*nodes[i].ptr()));
+                nodes[i].destroy();
+            }
+            count = keep;
+        }
+    };
+
+    static thread_state& local() noexcept {
+        static thread_local thread_state state;
+        return state;
+    }
+
+    // amortized: one scan of the thread records per retire_threshold retired objects.
+    static void retire_impl(void* p, deleter_t&& deleter) noexcept {
+        auto& state = local();
+        // the epoch must be read after p was unlinked, a stale one would expire p too early.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retired_ptr r(p, std::move(deleter), global_epoch.load(std::memory_order_relaxed));
+        UNLIKELY_IF(state.full()) {
+            UNLIKELY_IF(state.reclaiming) {
+                offload(std::move(r));
+                return;
+            }
+
+            // an object needs two advances, try the second one right away when the first paid off.
+            auto global = try_advance();
+            UNLIKELY_IF(!state.nodes[0].ptr()->expired(global)) {
+                global = try_advance();
+            }
+            state.reclaim(global);
+            state.shed();
+        }
+        state.push(std::move(r));
+    }
+
+    // reclaims what the calling thread retired, and the shared list.
+    static void sweep_and_reclaim() noexcept {
+        const auto global = try_advance();
+        auto& state = local();
+        if (!state.reclaiming) {
+            state.reclaim(global);
+        }
+        reclaim_orphans(global);
+    }
+
+    template <typename T>
+    static void retire(T* p) noexcept {
+        retire_impl(p, [](void* _p) noexcept {
+            delete static_cast<T*>(_p);
+        });
+    }
+
+    template <typename T, typename Deleter>
+    static void retire(T* p, Deleter deleter) {
+        static_assert(noexcept(std::declval<Deleter>()(std::declval<T*>())),
+            "Deleter(T*) must be noexcept");
+        retire_impl(p, [deleter = std::move(deleter)](void* _p) noexcept {
+            deleter(static_cast<T*>(_p));
+        });
+    }
+};
+
+// marks the calling thread as reading shared objects, guards nest and only the outermost one publishes.
+struct epoch_guard {
+    ebr_mgr::thread_state* state;
+
+public:
+    epoch_guard() noexcept
+        : state { &ebr_mgr::local() } {
+        LIKELY_IF(state->depth++ == 0) {
+            UNLIKELY_IF(!state->rec) {
+                state->rec = ebr_mgr::acquire_record();
+                assert(state->rec && "epoch_guard has no record, the thread table could not grow");
+            }
+            state->rec->epoch.store(ebr_mgr::global_epoch.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            // the epoch must be visible before any shared pointer is read, pairs with ebr_mgr::try_advance
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    ~epoch_guard() noexcept {
+        LIKELY_IF(--state->depth == 0) {
+            state->rec->epoch.store(ebr_mgr::quiescent, std::memory_order_release);
+        }
+    }
+
+    epoch_guard(const epoch_guard&) = delete;
+    epoch_guard& operator=(const epoch_guard&) = delete;
+};
+}
+
+#endif
@@ -1,12 +1,11 @@
-
 // hazard_ptr.cpp
 #include "hazard_ptr.h"
 
 namespace lite_fnds {
-	hp_mgr::hazard_record hp_mgr::record[hp_mgr::max_slot] {};
-#ifdef USE_HEAP_ALLOCATED
-	std::atomic<hp_mgr::retire_list_node*> hp_mgr::retire_list(nullptr);
-#else
-    static static_list<hp_mgr::retire_list_node, hp_mgr::max_slot << 1> retire_list;
+#ifdef HP_HAS_MEMBARRIER
+	const bool hp_impl::asymmetric_fence =
+		syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
 #endif
-}
\ No newline at end of file
+
+	template struct hp_domain<hp_default_tag>;
+}
@@ -1,42 +1,284 @@
 ﻿#ifndef LITE_FNDS_HAZARD_PTR_H
 #define LITE_FNDS_HAZARD_PTR_H
 
+#include <algorithm>
 #include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
 #include <thread>
 
-#include "utility/callable_wrapper.h"
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// opt-in: readers publish with a compiler fence only, reclaimers pay for a process wide membarrier instead.
+// Falls back to the symmetric fences when the kernel does not support it, the mode is picked in hazard_ptr.cpp.
+#if defined(HP_ASYMMETRIC_FENCE) && defined(__linux__) && !defined(TSAN_CLEAR)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#  define HP_HAS_MEMBARRIER 1
+#endif
+
+// the vector scans read the hazard cells with plain loads, keep them out of TSAN builds.
+#if !defined(TSAN_CLEAR) && (defined(__x86_64__) || defined(_M_X64))
+#include <immintrin.h>
+#  if defined(__AVX2__)
+#    define HP_SIMD_AVX2 1
+#  else
+#    define HP_SIMD_SSE2 1
+#  endif
+#endif
+
+#include "../utility/callable_wrapper.h"
 #include "../utility/static_list.h"
 
 namespace lite_fnds {
-struct hazard_ptr;
-
 template <typename Callable>
 using callable_t = callable_wrapper<Callable>;
 
-struct hp_mgr {
+namespace hp_impl {
+    using cell_t = std::atomic<const void*>;
+
+#ifdef HP_HAS_MEMBARRIER
+    // decided once for the whole process before main (hazard_ptr.cpp), so a reader's check is one plain
+    // load and readers and reclaimers always agree on the mode.
+    extern const bool asymmetric_fence;
+#endif
+
+    // cells is cache-line aligned and n a multiple of the vector width.
+    // The vector loads read the cells after the reclaimer's seq_cst fence, same as relaxed loads would.
+#if defined(HP_SIMD_AVX2)
+    inline bool scan_contains(const cell_t* cells, size_t n, const void* p) noexcept {
+        const auto base = reinterpret_cast<const __m256i*>(cells);
+        const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(reinterpret_cast<uintptr_t>(p)));
+        for (size_t i = 0; i < n / 4; i += 2) {
+            const __m256i a = _mm256_cmpeq_epi64(_mm256_load_si256(base + i), needle);
+            const __m256i b = _mm256_cmpeq_epi64(_mm256_load_si256(base + i + 1), needle);
+            if (_mm256_movemask_epi8(_mm256_or_si256(a, b))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline size_t scan_collect(const cell_t* cells, size_t n, const void** out) noexcept {
+        const auto base = reinterpret_cast<const __m256i*>(cells);
+        const auto raw = reinterpret_cast<const void* const*>(cells);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t count = 0;
+        for (size_t i = 0; i < n / 4; ++i) {
+            const __m256i v = _mm256_load_si256(base + i);
+            const int empty = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, zero)));
+            if (empty == 0xf) {
+                continue;
+            }
+            for (size_t j = 0; j < 4; ++j) {
+                if (!(empty & (1 << j))) {
+                    out[count++] = raw[i * 4 + j];
+                }
+            }
+        }
+        return count;
+    }
+#elif defined(HP_SIMD_SSE2)
+    inline bool scan_contains(const cell_t* cells, size_t n, const void* p) noexcept {
+        const auto base = reinterpret_cast<const __m128i*>(cells);
+        const __m128i needle = _mm_set1_epi64x(static_cast<long long>(reinterpret_cast<uintptr_t>(p)));
+        for (size_t i = 0; i < n / 2; ++i) {
+            // 64-bit equality out of two 32-bit halves
+            __m128i eq = _mm_cmpeq_epi32(_mm_load_si128(base + i), needle);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+            if (_mm_movemask_epi8(eq)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline size_t scan_collect(const cell_t* cells, size_t n, const void** out) noexcept {
+        const auto base = reinterpret_cast<const __m128i*>(cells);
+        const auto raw = reinterpret_cast<const void* const*>(cells);
+        const __m128i zero = _mm_setzero_si128();
+        size_t count = 0;
+        for (size_t i = 0; i < n / 2; ++i) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_load_si128(base + i), zero);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+            const int empty = _mm_movemask_pd(_mm_castsi128_pd(eq));
+            if (empty == 0x3) {
+                continue;
+            }
+            if (!(empty & 1)) {
+                out[count++] = raw[i * 2];
+            }
+            if (!(empty & 2)) {
+                out[count++] = raw[i * 2 + 1];
+            }
+        }
+        return count;
+    }
+#else
+    // acquire: a cleared cell must order the reader's last access before whatever the reclaimer frees.
+    inline bool scan_contains(const cell_t* cells, size_t n, const void* p) noexcept {
+        for (size_t i = 0; i < n; ++i) {
+            if (cells[i].load(std::memory_order_acquire) == p) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline size_t scan_collect(const cell_t* cells, size_t n, const void** out) noexcept {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto p = cells[i].load(std::memory_order_acquire);
+            if (p) {
+                out[count++] = p;
+            }
+        }
+        return count;
+    }
+#endif
+}
+
+// a domain owns its hazard table and retire list, hazards published in one domain are never scanned
+// for another. Tag tells domains apart, Slots is the number of cells per block of the table: size it
+// to the readers of the structures sharing the domain.
+//
+// struct queue_tag {};
+// using queue_domain = hp_domain<queue_tag, 16>;
+// basic_hazard_ptr<queue_domain> hp;
+// queue_domain::retire(node);
+template <typename Tag, size_t Slots = 128>
+struct hp_domain {
 public:
-    static constexpr size_t max_slot = 128;
+    // cells per block of the hazard table, the table grows by a block at a time.
+    static constexpr size_t max_slot = Slots;
+    static_assert(Slots && (Slots & (Slots - 1)) == 0, "Slots must be 2^n");
+    // runs of cells a thread keeps claimed after its hazard_ptrs are gone, they go back at thread exit.
+    static constexpr size_t cached_slot = 8;
     using deleter_t = callable_t<void(void*)>;
 
-#ifdef USE_HEAP_ALLOCATED
-    struct retire_list_node {
+    // a thread reclaims its own retired objects once it has collected this many of them.
+    static constexpr size_t retire_threshold = 64;
+    // threads expected to hand retire buffers over to the shared list at the same time.
+    static constexpr size_t expected_threads = 8;
+    // a batch of retire_threshold per thread, independent of Slots: a small domain still takes whole
+    // batches from its threads. The static build holds the shared list to it, a reclaim driver never
+    // lets more than this wait for its sweep.
+    static constexpr size_t retire_list_capacity = std::max(retire_threshold * expected_threads, retire_threshold << 2);
+    static_assert((retire_list_capacity & (retire_list_capacity - 1)) == 0, "retire_list_capacity must be 2^n");
+
+#ifdef HP_HAS_MEMBARRIER
+    static FORCE_INLINE bool asymmetric() noexcept {
+        return hp_impl::asymmetric_fence;
+    }
+#else
+    static constexpr bool asymmetric() noexcept {
+        return false;
+    }
+#endif
+
+    // store-load barrier between publishing a hazard and re-reading the protected pointer.
+    static FORCE_INLINE void reader_fence() noexcept {
+        LIKELY_IF(asymmetric()) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // the matching barrier before the hazards are read, in asymmetric mode it serializes every
+    // thread of the process, so the readers' plain stores are visible afterwards.
+    static void reclaimer_fence() noexcept {
+#ifdef HP_HAS_MEMBARRIER
+        LIKELY_IF(asymmetric()) {
+            syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+        }
+#endif
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    static FORCE_INLINE void publish(std::atomic<const void*>& cell, const void* p) noexcept {
+        cell.store(p, std::memory_order_release);
+        reader_fence();
+    }
+
+    struct retired_ptr {
         void* ptr;
         deleter_t deleter;
 
-        retire_list_node* next;
+        retired_ptr(const retired_ptr&) = delete;
+        retired_ptr& operator=(const retired_ptr&) = delete;
+
+        retired_ptr(retired_ptr&&) noexcept = default;
+        retired_ptr& operator=(retired_ptr&&) noexcept = default;
 
-        retire_list_node(const retire_list_node&) = delete;
-        retire_list_node& operator=(const retire_list_node&) = delete;
-        
         template <typename Deleter>
-        retire_list_node(void* p, Deleter _deleter)
-            : ptr(p), deleter(std::move(_deleter)) {
+        retired_ptr(void* p, Deleter _deleter)
+            noexcept(std::is_nothrow_constructible<deleter_t, Deleter&&>::value)
+            : ptr(p)
+            , deleter(std::move(_deleter)) {
+        }
+
+        void reclaim() noexcept {
+            deleter(ptr);
+        }
+    };
+
+    // every published hazard at one point in time, sorted so each lookup is a binary search.
+    struct hazard_snapshot {
+        const void* inline_ptrs[max_slot];
+        std::unique_ptr<const void*[]> heap_ptrs;
+        const void** ptrs = inline_ptrs;
+        size_t count = 0;
+        // false if the table has grown and no room could be allocated, everything counts as protected then.
+        bool complete = true;
+
+        hazard_snapshot() noexcept {
+            // pairs with the publication in hazard_ptr::protect
+            reclaimer_fence();
+
+            size_t blocks = 0;
+            for (auto block = &table; block; block = block->next.load(std::memory_order_acquire)) {
+                ++blocks;
+            }
+
+            UNLIKELY_IF(blocks > 1) {
+                heap_ptrs.reset(new (std::nothrow) const void*[blocks * max_slot]);
+                if (!heap_ptrs) {
+                    complete = false;
+                    return;
+                }
+                ptrs = heap_ptrs.get();
+            }
+
+            auto block = &table;
+            for (size_t i = 0; i < blocks; ++i, block = block->next.load(std::memory_order_acquire)) {
+                count += hp_impl::scan_collect(block->hazards, max_slot, ptrs + count);
+            }
+            std::sort(ptrs, ptrs + count);
+        }
+
+        hazard_snapshot(const hazard_snapshot&) = delete;
+        hazard_snapshot& operator=(const hazard_snapshot&) = delete;
+
+        bool contains(const void* p) const noexcept {
+            return !complete || std::binary_search(ptrs, ptrs + count, p);
         }
     };
 
+#ifdef USE_HEAP_ALLOCATED
+    struct retire_list_node : retired_ptr {
+        retire_list_node* next = nullptr;
+
+        using retired_ptr::retired_ptr;
+    };
+
     static std::atomic<retire_list_node*> retire_list;
 
-    static void append_to_retire_list(retire_list_node* node) {
+    static void append_to_retire_list(retire_list_node* node) noexcept {
         auto old_head = retire_list.load(std::memory_order_relaxed);
         do {
             node->next = old_head;
@@ -44,134 +286,475 @@ public:
             std::memory_order_release, std::memory_order_acquire));
     }
 
-    static void sweep_and_reclaim() noexcept {
+    static bool push_orphan(retired_ptr&& r) noexcept {
+        auto node = new (std::nothrow) retire_list_node(r.ptr, std::move(r.deleter));
+        if (!node) {
+            return false;
+        }
+        append_to_retire_list(node);
+        return true;
+    }
+
+    static void reclaim_orphans(const hazard_snapshot& snap) noexcept {
         auto list = retire_list.exchange(nullptr, std::memory_order_acq_rel);
         for (auto p = list; p;) {
             auto nxt = p->next;
-            if (!is_hazard(p->ptr)) {
-                p->deleter(p->ptr);
+            if (!snap.contains(p->ptr)) {
+                p->reclaim();
                 delete p;
             } else {
-                p->next = nullptr;
                 append_to_retire_list(p);
             }
             p = nxt;
         }
     }
+#else
+    using retire_list_node = retired_ptr;
 
-    template <typename T>
-    static void retire(T* p) {
-        if (!is_hazard(p)) {
-            delete p;
-        } else {
-            // append a new node to reclaim list
-            std::unique_ptr<retire_list_node> node = std::make_unique<retire_list_node>(p, [](void* p) {
-                      delete static_cast<T*>(p);
-                  });
-            append_to_retire_list(node.get());
-            node.release();
+    static static_list<retire_list_node, retire_list_capacity> retire_list;
+
+    static bool push_orphan(retired_ptr&& r) noexcept {
+        return retire_list.emplace(std::move(r));
+    }
+
+    // an entry taken off the list goes back, if other threads refilled it meanwhile it is leaked and counted.
+    static void keep(retired_ptr&& r) noexcept {
+        UNLIKELY_IF(!retire_list.emplace(std::move(r))) {
+            leaked.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
-    template <typename T, typename Deleter>
-    static void retire(T* p, Deleter deleter) {
-        static_assert(noexcept(std::declval<Deleter>()(std::declval<T*>())), "Deleter(T*) must be noexcept");
+    static void reclaim_orphans(const hazard_snapshot& snap) noexcept {
+        // the entries still protected after this round, pushed back once the list has been walked.
+        raw_inplace_storage_base<retire_list_node> kept[max_slot];
+        size_t n_kept = 0;
 
-        if (!is_hazard(p)) {
-            deleter(p);
-        } else {
-            // append a new node to reclaim list
-            std::unique_ptr<retire_list_node> node
-                = std::make_unique<retire_list_node>(p, [deleter = std::move(deleter)](void* p) {
-                      deleter(static_cast<T*>(p));
-                  });
+        for (size_t n = retire_list_capacity; n; --n) {
+            inplace_t<retire_list_node> node = retire_list.pop();
+            if (!node.has_value()) {
+                break;
+            }
 
-            append_to_retire_list(node.get());
-            node.release();
+            if (!snap.contains(node.get().ptr)) {
+                node.get().reclaim();
+            } else if (n_kept < max_slot) {
+                kept[n_kept++].construct(node.steal());
+            } else {
+                keep(node.steal());
+            }
+        }
+
+        for (size_t i = 0; i < n_kept; ++i) {
+            keep(std::move(*kept[i].ptr()));
+            kept[i].destroy();
         }
     }
-#else
-    struct retire_list_node {
-        void* ptr;
-        deleter_t deleter;
+#endif
 
-        retire_list_node(const retire_list_node&) = delete;
-        retire_list_node& operator=(const retire_list_node&) = delete;
+    // objects that are never reclaimed because both the thread buffer and the shared list were full
+    // (also when the list refilled while reclaim_orphans had a still protected entry off it).
+    static std::atomic<size_t> leaked;
 
-        retire_list_node(retire_list_node&&) noexcept = default;
-        retire_list_node& operator=(retire_list_node&&) noexcept  = default;
+    static size_t leaked_count() noexcept {
+        return leaked.load(std::memory_order_relaxed);
+    }
 
-        template <typename Deleter>
-        retire_list_node(void* p, Deleter _deleter)
-            : ptr(p)
-            , deleter(std::move(_deleter)) {
+    // hands a retired object over to the shared list, as a last resort it is leaked and counted.
+    static void offload(retired_ptr&& r) noexcept {
+        LIKELY_IF(push_orphan(std::move(r))) {
+            return;
+        }
+
+        {
+            hazard_snapshot snap;
+            reclaim_orphans(snap);
+        }
+
+        UNLIKELY_IF(!push_orphan(std::move(r))) {
+            leaked.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    struct retire_buffer {
+        raw_inplace_storage_base<retired_ptr> nodes[retire_threshold];
+        size_t count = 0;
+        bool reclaiming = false;
+
+        retire_buffer() noexcept = default;
+        retire_buffer(const retire_buffer&) = delete;
+        retire_buffer& operator=(const retire_buffer&) = delete;
+
+        // the thread is gone, whatever is still protected moves to the shared list.
+        ~retire_buffer() noexcept {
+            hazard_snapshot snap;
+            reclaim(snap);
+            for (size_t i = 0; i < count; ++i) {
+                offload(std::move(*nodes[i].ptr()));
+                nodes[i].destroy();
+            }
+            count = 0;
+        }
+
+        bool full() const noexcept {
+            return count == retire_threshold;
+        }
+
+        void push(retired_ptr&& r) noexcept {
+            nodes[count++].construct(std::move(r));
+        }
+
+        // a deleter may retire further objects while this runs, they are appended behind the scanned range.
+        void reclaim(const hazard_snapshot& snap) noexcept {
+            reclaiming = true;
+            const size_t n = count;
+            size_t kept = 0;
+            for (size_t i = 0; i < n; ++i) {
+                auto& node = *nodes[i].ptr();
+                if (!snap.contains(node.ptr)) {
+                    node.reclaim();
+                    nodes[i].destroy();
+                    continue;
+                }
+
+                if (kept != i) {
+                    nodes[kept].construct(std::move(node));
+                    nodes[i].destroy();
+                }
+                ++kept;
+            }
+
+            for (size_t i = n; i < count; ++i, ++kept) {
+                nodes[kept].construct(std::move(*nodes[i].ptr()));
+                nodes[i].destroy();
+            }
+            count = kept;
+            reclaiming = false;
+        }
+
+        // keeps at least half of the buffer free, so a long-protected object never stalls retire.
+        void shed(size_t keep = retire_threshold >> 1) noexcept {
+            while (count > keep) {
+                --count;
+                offload(std::move(*nodes[count].ptr()));
+                nodes[count].destroy();
+            }
         }
     };
 
-    static static_list<retire_list_node, max_slot << 1> retire_list;
+    static retire_buffer& local_retired() noexcept {
+        static thread_local retire_buffer buffer;
+        return buffer;
+    }
 
-    static void sweep_and_reclaim() noexcept {
-        for (inplace_t<retire_list_node> node = retire_list.pop(); 
-            node.has_value(); 
-            node = retire_list.pop()) {
-         
-            if (!is_hazard(node.get().ptr)) {
-                node.get().deleter(node.get().ptr);
-            } else {
-                retire_list.emplace(node.steal());
+    // installed by a reclaim driver (see reclaim_driver.h). While one is attached, a full retire buffer
+    // is handed to the shared list and the driver is woken up, the retiring thread only scans itself
+    // when the driver has fallen retire_list_capacity objects behind.
+    struct reclaim_hook {
+        void (*wake)(reclaim_hook* self, size_t pending) noexcept;
+    };
+
+    static std::atomic<reclaim_hook*> hook;
+    // threads inside hook->wake, detach waits for them before the hook may go away.
+    static std::atomic<size_t> hook_users;
+    // objects handed to the shared list since the last sweep.
+    static std::atomic<size_t> pending;
+
+    static size_t pending_count() noexcept {
+        return pending.load(std::memory_order_relaxed);
+    }
+
+    static void attach_hook(reclaim_hook* h) noexcept {
+        hook.store(h, std::memory_order_seq_cst);
+    }
+
+    static void detach_hook() noexcept {
+        hook.store(nullptr, std::memory_order_seq_cst);
+        while (hook_users.load(std::memory_order_seq_cst)) {
+            std::this_thread::yield();
+        }
+    }
+
+    static bool defer_to_driver(retire_buffer& buffer) noexcept {
+        hook_users.fetch_add(1, std::memory_order_seq_cst);
+        auto h = hook.load(std::memory_order_seq_cst);
+        LIKELY_IF(!h) {
+            hook_users.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        // only what the shared list has room for is handed over, the rest stays in the buffer.
+        size_t queued = pending.load(std::memory_order_relaxed);
+        size_t n = 0;
+        do {
+            n = queued < retire_list_capacity ? std::min(buffer.count, retire_list_capacity - queued) : 0;
+        } while (n && !pending.compare_exchange_weak(queued, queued + n, std::memory_order_relaxed));
+
+        buffer.shed(buffer.count - n);
+        h->wake(h, queued + n);
+        hook_users.fetch_sub(1, std::memory_order_release);
+        return n != 0;
+    }
+
+    // amortized: one snapshot of the hazards per retire_threshold retired objects.
+    static void retire_impl(retired_ptr&& r) noexcept {
+        auto& buffer = local_retired();
+        UNLIKELY_IF(buffer.full()) {
+            UNLIKELY_IF(buffer.reclaiming) {
+                offload(std::move(r));
+                return;
+            }
+
+            UNLIKELY_IF(!hook.load(std::memory_order_relaxed) || !defer_to_driver(buffer)) {
+                hazard_snapshot snap;
+                buffer.reclaim(snap);
+                buffer.shed();
             }
         }
+        buffer.push(std::move(r));
     }
 
-    template <typename T>
-    static void retire(T* p) {
-        if (!is_hazard(p)) {
-            delete p;
-        } else {
-            // append a new node to reclaim list
-            retire_list.emplace(p, [](void* _p) noexcept {
-                delete static_cast<T*>(_p);
-            });
+    // reclaims what the calling thread retired, and the shared list.
+    static void sweep_and_reclaim() noexcept {
+        pending.store(0, std::memory_order_relaxed);
+        hazard_snapshot snap;
+        auto& buffer = local_retired();
+        if (!buffer.reclaiming) {
+            buffer.reclaim(snap);
         }
+        reclaim_orphans(snap);
+    }
+
+    template <typename T>
+    static void retire(T* p) noexcept {
+        retire_impl(retired_ptr(p, [](void* _p) noexcept {
+            delete static_cast<T*>(_p);
+        }));
     }
 
     template <typename T, typename Deleter>
     static void retire(T* p, Deleter deleter) {
-        static_assert(noexcept(std::declval<Deleter>()(std::declval<T*>())), 
+        static_assert(noexcept(std::declval<Deleter>()(std::declval<T*>())),
             "Deleter(T*) must be noexcept");
-        if (!is_hazard(p)) {
-            deleter(p);
-        } else {
-            // append a new node to reclaim list
-            retire_list.emplace(p, [deleter = std::move(deleter)](void* p) noexcept {
-                deleter(static_cast<T*>(p));
-            });
+        retire_impl(retired_ptr(p, [deleter = std::move(deleter)](void* _p) noexcept {
+            deleter(static_cast<T*>(_p));
+        }));
+    }
+
+    // published hazards are dense, CACHE_LINE_SIZE / sizeof(void*) of them per line, so a scan reads
+    // max_slot / hazards_per_line lines per block. Ownership lives in a separate array which scans never touch.
+    using hazard_cell = std::atomic<const void*>;
+    static_assert(sizeof(hazard_cell) == sizeof(const void*), "hazard_cell must be a plain pointer");
+
+    static constexpr size_t hazards_per_line = CACHE_LINE_SIZE / sizeof(hazard_cell);
+    static constexpr size_t hazard_lines = max_slot / hazards_per_line;
+    static_assert(max_slot % hazards_per_line == 0, "max_slot must fill whole cache lines");
+
+    // the table starts with one static block of max_slot cells, when it runs out a new block is linked
+    // behind the last one. Blocks are never unlinked, so readers and scans never wait for a resize.
+    struct hazard_block {
+        alignas(CACHE_LINE_SIZE) hazard_cell hazards[max_slot];
+        std::atomic<std::thread::id> owner[max_slot];
+        std::atomic<hazard_block*> next { nullptr };
+
+        bool contains(const hazard_cell* cell) const noexcept {
+            return cell >= hazards && cell < hazards + max_slot;
+        }
+
+        bool try_claim(size_t i, size_t len, const std::thread::id tid) noexcept {
+            for (size_t j = 0; j < len; ++j) {
+                auto exp = std::thread::id();
+                if (!owner[i + j].compare_exchange_strong(exp, tid,
+                        std::memory_order_release, std::memory_order_relaxed)) {
+                    while (j) {
+                        owner[i + --j].store(std::thread::id(), std::memory_order_release);
+                    }
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool line_is_free(size_t line) const noexcept {
+            for (size_t j = 0; j < hazards_per_line; ++j) {
+                if (owner[line * hazards_per_line + j].load(std::memory_order_relaxed) != std::thread::id()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // single cells are spread line by line (cell 0 of every line first, then cell 1 ...),
+        // so up to hazard_lines threads publish without writing into each other's lines.
+        // Runs of len > 1 cells stay inside one line, an unused line is preferred.
+        hazard_cell* claim(const std::thread::id tid, size_t len) noexcept {
+            if (len == 1) {
+                for (size_t k = 0; k < max_slot; ++k) {
+                    const size_t i = (k % hazard_lines) * hazards_per_line + k / hazard_lines;
+                    if (try_claim(i, 1, tid)) {
+                        return &hazards[i];
+                    }
+                }
+                return nullptr;
+            }
+
+            for (size_t line = 0; line < hazard_lines; ++line) {
+                if (line_is_free(line) && try_claim(line * hazards_per_line, len, tid)) {
+                    return &hazards[line * hazards_per_line];
+                }
+            }
+
+            for (size_t line = 0; line < hazard_lines; ++line) {
+                for (size_t start = hazards_per_line - len + 1; start-- > 0;) {
+                    const size_t i = line * hazards_per_line + start;
+                    if (try_claim(i, len, tid)) {
+                        return &hazards[i];
+                    }
+                }
+            }
+            return nullptr;
         }
+    };
+
+    static hazard_block table;
+
+    static hazard_block* new_block() noexcept {
+        void* p = nullptr;
+#ifdef _WIN32
+        p = _aligned_malloc(sizeof(hazard_block), CACHE_LINE_SIZE);
+#else
+        if (posix_memalign(&p, CACHE_LINE_SIZE, sizeof(hazard_block)) != 0) {
+            p = nullptr;
+        }
+#endif
+        return p ? new (p) hazard_block() : nullptr;
     }
 
+    static void delete_block(hazard_block* block) noexcept {
+        block->~hazard_block();
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        free(block);
 #endif
-    struct alignas(CACHE_LINE_SIZE) hazard_record {
-        std::atomic<std::thread::id> tid;
-        std::atomic<const void*> ptr;
-        pad_t<sizeof(tid) + sizeof(ptr)> pad;
+    }
+
+    // claims len contiguous cells of one line, linking a new block when every block is taken.
+    static hazard_cell* acquire_slots(const std::thread::id tid, size_t len) noexcept {
+        assert(len > 0 && len <= hazards_per_line);
+        hazard_block* block = &table;
+        for (;;) {
+            if (auto cells = block->claim(tid, len)) {
+                return cells;
+            }
+
+            auto nxt = block->next.load(std::memory_order_acquire);
+            if (nxt) {
+                block = nxt;
+                continue;
+            }
+
+            auto fresh = new_block();
+            if (!fresh) {
+                return nullptr;
+            }
+
+            // claimed before the block is visible, so it can't be taken away by someone else.
+            auto cells = fresh->claim(tid, len);
+            if (block->next.compare_exchange_strong(nxt, fresh,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return cells;
+            }
+
+            // lost the race, the winner's block is in nxt now.
+            delete_block(fresh);
+            block = nxt;
+        }
+    }
+
+    static hazard_cell* acquire_slot(const std::thread::id tid) noexcept {
+        return acquire_slots(tid, 1);
+    }
+
+    static void release_slots(hazard_cell* cells, size_t len) noexcept {
+        for (auto block = &table; block; block = block->next.load(std::memory_order_acquire)) {
+            if (block->contains(cells)) {
+                const size_t i = static_cast<size_t>(cells - block->hazards);
+                for (size_t j = 0; j < len; ++j) {
+                    block->owner[i + j].store(std::thread::id(), std::memory_order_release);
+                }
+                return;
+            }
+        }
+    }
+
+    static void release_slot(hazard_cell* slot) noexcept {
+        release_slots(slot, 1);
+    }
+
+    // runs of cells claimed by the current thread and not in use by any hazard_ptr / hazard_array
+    struct local_slots {
+        struct run {
+            hazard_cell* cells;
+            size_t len;
+        };
+
+        run runs[cached_slot];
+        size_t count = 0;
+
+        local_slots() noexcept = default;
+        local_slots(const local_slots&) = delete;
+        local_slots& operator=(const local_slots&) = delete;
+
+        ~local_slots() noexcept {
+            while (count) {
+                --count;
+                release_slots(runs[count].cells, runs[count].len);
+            }
+        }
     };
-    static hazard_record record[max_slot];
-    friend struct hazard_ptr;
 
-    static hazard_record* acquire_slot(const std::thread::id tid) noexcept {
-        for (int i = 0; i < max_slot; ++i) {
-            auto exp = std::thread::id();
-            if (record[i].tid.compare_exchange_strong(exp, tid,
-                    std::memory_order_release, std::memory_order_relaxed)) {
-                return &record[i];
+    static local_slots& local() noexcept {
+        static thread_local local_slots slots;
+        return slots;
+    }
+
+    // a thread-local lookup in the common case, the table is only scanned when the cache has no such run.
+    static hazard_cell* get_slots(size_t len) noexcept {
+        auto& l = local();
+        for (size_t i = l.count; i-- > 0;) {
+            LIKELY_IF(l.runs[i].len == len) {
+                auto cells = l.runs[i].cells;
+                l.runs[i] = l.runs[--l.count];
+                return cells;
             }
         }
-        return nullptr;
+        return acquire_slots(std::this_thread::get_id(), len);
+    }
+
+    static hazard_cell* get_slot() noexcept {
+        return get_slots(1);
+    }
+
+    // the cells must not protect anything when they are handed back.
+    static void put_slots(hazard_cell* cells, size_t len) noexcept {
+        auto& l = local();
+        LIKELY_IF(l.count < cached_slot) {
+            l.runs[l.count++] = { cells, len };
+            return;
+        }
+        release_slots(cells, len);
+    }
+
+    static void put_slot(hazard_cell* slot) noexcept {
+        put_slots(slot, 1);
     }
 
+    // exact like the batched scans, so it pays the same reclaimer fence (a membarrier in asymmetric
+    // mode) on every call; retire and sweep_and_reclaim take it once per batch instead.
     static bool is_hazard(const void* ptr) noexcept {
-        for (size_t i = 0; i < max_slot; ++i) {
-            if (record[i].ptr.load(std::memory_order_acquire) == ptr) {
+        reclaimer_fence();
+        for (auto block = &table; block; block = block->next.load(std::memory_order_acquire)) {
+            if (hp_impl::scan_contains(block->hazards, max_slot, ptr)) {
                 return true;
             }
         }
@@ -179,30 +762,61 @@ public:
     }
 };
 
-struct hazard_ptr {
-    using hazard_record = typename hp_mgr::hazard_record;
-    hazard_record* slot;
+template <typename Tag, size_t Slots>
+typename hp_domain<Tag, Slots>::hazard_block hp_domain<Tag, Slots>::table;
+
+template <typename Tag, size_t Slots>
+std::atomic<size_t> hp_domain<Tag, Slots>::leaked { 0 };
+
+template <typename Tag, size_t Slots>
+std::atomic<typename hp_domain<Tag, Slots>::reclaim_hook*> hp_domain<Tag, Slots>::hook { nullptr };
+
+template <typename Tag, size_t Slots>
+std::atomic<size_t> hp_domain<Tag, Slots>::hook_users { 0 };
+
+template <typename Tag, size_t Slots>
+std::atomic<size_t> hp_domain<Tag, Slots>::pending { 0 };
+
+#ifdef USE_HEAP_ALLOCATED
+template <typename Tag, size_t Slots>
+std::atomic<typename hp_domain<Tag, Slots>::retire_list_node*> hp_domain<Tag, Slots>::retire_list(nullptr);
+#else
+template <typename Tag, size_t Slots>
+static_list<typename hp_domain<Tag, Slots>::retire_list_node, hp_domain<Tag, Slots>::retire_list_capacity>
+    hp_domain<Tag, Slots>::retire_list;
+#endif
+
+// the process wide domain, used by hazard_ptr / hazard_array. Instantiated once in hazard_ptr.cpp.
+struct hp_default_tag {};
+using hp_mgr = hp_domain<hp_default_tag>;
+extern template struct hp_domain<hp_default_tag>;
+
+template <typename Domain>
+struct basic_hazard_ptr {
+    using domain_type = Domain;
+    using hazard_cell = typename Domain::hazard_cell;
+    hazard_cell* slot;
 
 public:
-    hazard_ptr() noexcept
-        : slot { hp_mgr::acquire_slot(std::this_thread::get_id()) } {
+    basic_hazard_ptr() noexcept
+        : slot { Domain::get_slot() } {
     }
 
-    ~hazard_ptr() noexcept {
+    ~basic_hazard_ptr() noexcept {
         release_slot();
     }
 
-    hazard_ptr(const hazard_ptr&) = delete;
-    hazard_ptr& operator=(const hazard_ptr&) = delete;
+    basic_hazard_ptr(const basic_hazard_ptr&) = delete;
+    basic_hazard_ptr& operator=(const basic_hazard_ptr&) = delete;
 
-    hazard_ptr(hazard_ptr&& hp) noexcept
+    basic_hazard_ptr(basic_hazard_ptr&& hp) noexcept
         : slot(hp.slot) {
         hp.slot = nullptr;
     }
 
-    hazard_ptr& operator=(hazard_ptr&& hp) noexcept {
+    basic_hazard_ptr& operator=(basic_hazard_ptr&& hp) noexcept {
         if (this != &hp) {
-            hazard_ptr tmp(std::move(hp));
+            basic_hazard_ptr tmp(std::move(hp));
             this->swap(tmp);
         }
         return *this;
@@ -213,35 +827,35 @@ public:
         return slot != nullptr;
     }
 
-    hazard_record* acquire_slot() noexcept {
-        return slot ? slot : slot = hp_mgr::acquire_slot(std::this_thread::get_id());
+    hazard_cell* acquire_slot() noexcept {
+        return slot ? slot : slot = Domain::get_slot();
     }
 
-    void swap(hazard_ptr& rhs) noexcept {
+    void swap(basic_hazard_ptr& rhs) noexcept {
         using std::swap;
         swap(slot, rhs.slot);
     }
 
     // you must check if the hp is available before calling protect
     void protect(const void* p) noexcept {
-        assert(slot && "hazard_ptr slot exhausted, increase max_slot or reduce concurrent HP usage");
-        slot->ptr.store(p, std::memory_order_release);
+        assert(slot && "hazard_ptr has no slot, the hazard table could not grow");
+        Domain::publish(*slot, p);
     }
 
     void unprotect() noexcept {
-        slot->ptr.store(nullptr, std::memory_order_release);
+        slot->store(nullptr, std::memory_order_release);
     }
 
     void release_slot() noexcept {
         if (slot) {
             unprotect();
-            slot->tid.store(std::thread::id(), std::memory_order_release);
+            Domain::put_slot(slot);
             slot = nullptr;
         }
     }
 
     static bool is_hazard(const void* p) noexcept {
-        return hp_mgr::is_hazard(p);
+        return Domain::is_hazard(p);
     }
 
     template <typename T>
@@ -255,10 +869,106 @@ public:
     }
 };
 
-inline void swap(hazard_ptr& lhs, hazard_ptr& rhs) noexcept {
+template <typename Domain>
+void swap(basic_hazard_ptr<Domain>& lhs, basic_hazard_ptr<Domain>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+using hazard_ptr = basic_hazard_ptr<hp_mgr>;
+
+// K hazards claimed as one run of contiguous cells in a single cache line, for traversals
+// which have to hold several nodes at once (prev / cur / next ...).
+template <typename Domain, size_t K>
+struct basic_hazard_array {
+    static_assert(K > 0 && K <= Domain::hazards_per_line, "hazard_array must fit in one cache line");
+
+    using domain_type = Domain;
+    using hazard_cell = typename Domain::hazard_cell;
+    hazard_cell* cells;
+
+public:
+    basic_hazard_array() noexcept
+        : cells { Domain::get_slots(K) } {
+    }
+
+    ~basic_hazard_array() noexcept {
+        release_slots();
+    }
+
+    basic_hazard_array(const basic_hazard_array&) = delete;
+    basic_hazard_array& operator=(const basic_hazard_array&) = delete;
+
+    basic_hazard_array(basic_hazard_array&& rhs) noexcept
+        : cells(rhs.cells) {
+        rhs.cells = nullptr;
+    }
+
+    basic_hazard_array& operator=(basic_hazard_array&& rhs) noexcept {
+        if (this != &rhs) {
+            basic_hazard_array tmp(std::move(rhs));
+            this->swap(tmp);
+        }
+        return *this;
+    }
+
+    static constexpr size_t size() noexcept {
+        return K;
+    }
+
+    // you must check if the array is available before calling protect
+    bool available() const noexcept {
+        return cells != nullptr;
+    }
+
+    void swap(basic_hazard_array& rhs) noexcept {
+        using std::swap;
+        swap(cells, rhs.cells);
+    }
+
+    void protect(size_t i, const void* p) noexcept {
+        assert(cells && "hazard_array has no slots, the hazard table could not grow");
+        assert(i < K);
+        Domain::publish(cells[i], p);
+    }
+
+    void unprotect(size_t i) noexcept {
+        assert(i < K);
+        cells[i].store(nullptr, std::memory_order_release);
+    }
+
+    void unprotect_all() noexcept {
+        for (size_t i = 0; i < K; ++i) {
+            cells[i].store(nullptr, std::memory_order_release);
+        }
+    }
+
+    void release_slots() noexcept {
+        if (cells) {
+            unprotect_all();
+            Domain::put_slots(cells, K);
+            cells = nullptr;
+        }
+    }
+
+    template <typename T>
+    T* acquire_protected(size_t i, std::atomic<T*>& target) noexcept {
+        T* p {};
+        do {
+            p = target.load(std::memory_order_acquire);
+            protect(i, p);
+        } while (p != target.load(std::memory_order_acquire));
+        return p;
+    }
+};
+
+template <typename Domain, size_t K>
+void swap(basic_hazard_array<Domain, K>& lhs, basic_hazard_array<Domain, K>& rhs) noexcept {
     lhs.swap(rhs);
 }
 
+template <size_t K>
+using hazard_array = basic_hazard_array<hp_mgr, K>;
+
 }
 
 #endif
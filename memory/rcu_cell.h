@@ -0,0 +1,168 @@
+#ifndef LITE_FNDS_RCU_CELL_H
+#define LITE_FNDS_RCU_CELL_H
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "hazard_ptr.h"
+
+/**
+ * rcu_cell<T>: a shared, read-mostly snapshot (config, routing table, blueprint set ...)
+ *
+ * rcu_cell<config> cfg(make_config());
+ *
+ * auto snap = cfg.load();              // no refcount, one hazard publish
+ * use(snap->timeout);                  // snap keeps the object alive, it is never modified
+ *
+ * cfg.store(make_config());            // the old snapshot is retired, freed once no reader holds it
+ * cfg.update([](config& c) { ++c.version; });   // copy, modify, publish
+ *
+ * Loads are lock-free, not wait-free: a load retries for as long as stores keep landing between its
+ * two reads of the cell. Stores never wait for readers.
+ */
+
+namespace lite_fnds {
+template <typename T, typename Domain = hp_mgr>
+class rcu_cell {
+    static_assert(std::is_nothrow_destructible<T>::value, "T must be nothrow destructible");
+
+    std::atomic<T*> _p;
+
+    static void retire(T* p) noexcept {
+        if (p) {
+            Domain::retire(p);
+        }
+    }
+
+    static T* copy_of(const T* p, std::true_type /*default constructible*/) {
+        return p ? new T(*p) : new T();
+    }
+
+    static T* copy_of(const T* p, std::false_type) {
+        assert(p && "rcu_cell: update of an empty cell needs a default constructible T");
+        return new T(*p);
+    }
+
+public:
+    // keeps the object it was loaded with alive, one per thread and snapshot in use.
+    class snapshot {
+        basic_hazard_ptr<Domain> hp;
+        const T* p;
+
+        friend class rcu_cell;
+
+        explicit snapshot(std::atomic<T*>& cell) noexcept
+            : p { nullptr } {
+            assert(hp.available() && "rcu_cell: no hazard slot available");
+            p = hp.acquire_protected(cell);
+        }
+
+    public:
+        snapshot(snapshot&& rhs) noexcept
+            : hp(std::move(rhs.hp))
+            , p(rhs.p) {
+            rhs.p = nullptr;
+        }
+
+        snapshot& operator=(snapshot&& rhs) noexcept {
+            if (this != &rhs) {
+                hp = std::move(rhs.hp);
+                p = rhs.p;
+                rhs.p = nullptr;
+            }
+            return *this;
+        }
+
+        snapshot(const snapshot&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+
+        const T* get() const noexcept {
+            return p;
+        }
+
+        const T& operator*() const noexcept {
+            assert(p && "attempting to dereference an empty snapshot");
+            return *p;
+        }
+
+        const T* operator->() const noexcept {
+            assert(p && "attempting to dereference an empty snapshot");
+            return p;
+        }
+
+        explicit operator bool() const noexcept {
+            return p != nullptr;
+        }
+
+        // drops the protection early
+        void reset() noexcept {
+            hp.release_slot();
+            p = nullptr;
+        }
+    };
+
+    constexpr rcu_cell() noexcept
+        : _p { nullptr } {
+    }
+
+    // takes ownership of p
+    explicit rcu_cell(T* p) noexcept
+        : _p { p } {
+    }
+
+    explicit rcu_cell(std::unique_ptr<T> p) noexcept
+        : _p { p.release() } {
+    }
+
+    // readers may still hold snapshots, the last object is retired rather than deleted.
+    ~rcu_cell() noexcept {
+        retire(_p.load(std::memory_order_relaxed));
+    }
+
+    rcu_cell(const rcu_cell&) = delete;
+    rcu_cell& operator=(const rcu_cell&) = delete;
+
+    snapshot load() noexcept {
+        return snapshot(_p);
+    }
+
+    // takes ownership of p, the previous object is retired.
+    void store(T* p) noexcept {
+        retire(_p.exchange(p, std::memory_order_acq_rel));
+    }
+
+    void store(std::unique_ptr<T> p) noexcept {
+        store(p.release());
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        store(new T(std::forward<Args>(args)...));
+    }
+
+    // copies the current object, lets f modify the copy and publishes it. An empty cell starts from
+    // a default constructed T, if T has no default constructor the cell must not be empty.
+    // Retries if another store got in between, so f may run more than once.
+    template <typename F>
+    void update(F&& f) {
+        for (;;) {
+            auto snap = load();
+            std::unique_ptr<T> next(copy_of(snap.get(), std::is_default_constructible<T> {}));
+            f(*next);
+
+            T* expected = const_cast<T*>(snap.get());
+            if (_p.compare_exchange_strong(expected, next.get(),
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                next.release();
+                snap.reset();
+                retire(expected);
+                return;
+            }
+        }
+    }
+};
+}
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef LITE_FNDS_RECLAIM_DRIVER_H
+#define LITE_FNDS_RECLAIM_DRIVER_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "hazard_ptr.h"
+#include "../task/task_wrapper.h"
+
+/**
+ * Moves hazard pointer reclamation off the retiring threads.
+ *
+ * While a driver is attached to a domain, a thread whose retire buffer fills up hands the buffer to
+ * the domain's shared list and wakes the driver, the hazard scan runs on the driver side. What the
+ * shared list has no room for stays in the buffer, the thread scans itself only if nothing fits.
+ * At most one driver should be attached to a domain at a time.
+ *
+ * executor_reclaim_driver<gsource_executor<64>*> drv(&executor);  // sweeps run as executor tasks
+ * reclaim_thread<> thr;                                            // or a dedicated low priority thread
+ *
+ * executor_reclaim_driver holds the executor like task_group does: any pointer-like Executor with
+ * exec->dispatch(task_wrapper_sbo&&). A raw pointer has to outlive the driver and every sweep it
+ * dispatched, a std::shared_ptr keeps the executor alive for as long as the driver. The executors
+ * here have no idle callback to register with, so sweeping on idle is up to the owner: call
+ * on_idle() from wherever the executor's thread runs out of work, e.g. a GLib idle source next to
+ * a gsource_executor. Without those calls the driver still sweeps once the watermark is passed.
+ */
+
+namespace lite_fnds {
+    namespace reclaim_driver_impl {
+        // one sweep in flight per domain, shared by the dispatched tasks which never see the driver.
+        template <typename Domain>
+        struct sweep_state {
+            static std::atomic<bool> scheduled;
+        };
+
+        template <typename Domain>
+        std::atomic<bool> sweep_state<Domain>::scheduled { false };
+    }
+
+    // sweeps as tasks of exec (pointer-like, exec->dispatch(task_wrapper_sbo&&)).
+    template <typename Executor, typename Domain = hp_mgr>
+    class executor_reclaim_driver : Domain::reclaim_hook {
+        using hook_t = typename Domain::reclaim_hook;
+        using state_t = reclaim_driver_impl::sweep_state<Domain>;
+
+        Executor executor_;
+        size_t watermark_;
+
+        static void wake(hook_t* self, size_t pending) noexcept {
+            auto driver = static_cast<executor_reclaim_driver*>(self);
+            if (pending >= driver->watermark_) {
+                driver->schedule();
+            }
+        }
+
+    public:
+        // half of what the shared list takes, the sweep starts well before retiring threads have to scan.
+        static constexpr size_t default_watermark = Domain::retire_list_capacity >> 1;
+
+        explicit executor_reclaim_driver(Executor executor, size_t watermark = default_watermark)
+            noexcept(std::is_nothrow_move_constructible<Executor>::value)
+            : hook_t { &executor_reclaim_driver::wake }
+            , executor_ { std::move(executor) }
+            , watermark_ { watermark } {
+            assert(executor_ && "executor_reclaim_driver needs an executor");
+            Domain::attach_hook(this);
+        }
+
+        executor_reclaim_driver(const executor_reclaim_driver&) = delete;
+        executor_reclaim_driver& operator=(const executor_reclaim_driver&) = delete;
+
+        // a sweep already dispatched still runs, it does not touch the driver.
+        ~executor_reclaim_driver() noexcept {
+            Domain::detach_hook();
+        }
+
+        void schedule() noexcept {
+            if (state_t::scheduled.exchange(true, std::memory_order_acq_rel)) {
+                return;
+            }
+
+            executor_->dispatch(task_wrapper_sbo([]() noexcept {
+                state_t::scheduled.store(false, std::memory_order_release);
+                Domain::sweep_and_reclaim();
+            }));
+        }
+
+        // idle time is free, sweep whatever has been handed over. Not called by the driver itself,
+        // the owner calls it from the executor's idle path.
+        void on_idle() noexcept {
+            if (Domain::pending_count()) {
+                Domain::sweep_and_reclaim();
+            }
+        }
+    };
+
+    // a thread which sleeps until the watermark is passed, or at most one interval.
+    // On Linux it runs under SCHED_IDLE, so it only gets the cpu time nobody else wants.
+    template <typename Domain = hp_mgr>
+    class reclaim_thread : Domain::reclaim_hook {
+        using hook_t = typename Domain::reclaim_hook;
+
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::atomic<bool> signaled_;
+        bool stop_;
+        size_t watermark_;
+        std::chrono::milliseconds interval_;
+        std::thread worker_;
+
+        static void wake(hook_t* self, size_t pending) noexcept {
+            auto driver = static_cast<reclaim_thread*>(self);
+            if (pending >= driver->watermark_
+                && !driver->signaled_.exchange(true, std::memory_order_acq_rel)) {
+                // no lock here, a lost notify only delays the sweep by one interval.
+                driver->cv_.notify_one();
+            }
+        }
+
+        void run() noexcept {
+#ifdef __linux__
+            sched_param param {};
+            (void)pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+            std::unique_lock<std::mutex> lk(mtx_);
+            while (!stop_) {
+                cv_.wait_for(lk, interval_, [this] {
+                    return stop_ || signaled_.load(std::memory_order_acquire);
+                });
+
+                signaled_.store(false, std::memory_order_release);
+                lk.unlock();
+                if (Domain::pending_count()) {
+                    Domain::sweep_and_reclaim();
+                }
+                lk.lock();
+            }
+        }
+
+    public:
+        static constexpr size_t default_watermark = Domain::retire_list_capacity >> 1;
+
+        explicit reclaim_thread(std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+            size_t watermark = default_watermark)
+            : hook_t { &reclaim_thread::wake }
+            , signaled_ { false }
+            , stop_ { false }
+            , watermark_ { watermark }
+            , interval_ { interval }
+            , worker_ { [this] { run(); } } {
+            Domain::attach_hook(this);
+        }
+
+        reclaim_thread(const reclaim_thread&) = delete;
+        reclaim_thread& operator=(const reclaim_thread&) = delete;
+
+        ~reclaim_thread() noexcept {
+            Domain::detach_hook();
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            worker_.join();
+            // whatever was handed over after the last round
+            Domain::sweep_and_reclaim();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef LITE_FNDS_REF_PTR_H
+#define LITE_FNDS_REF_PTR_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "../base/traits.h"
+
+/**
+ * ref_ptr: intrusive reference counted pointer
+ *
+ * The counter lives inside the object (through ref_counted), so there is no
+ * separate control block and a ref_ptr is exactly one pointer wide.
+ *
+ * struct foo : ref_counted<foo> { ... };                        // atomic counting, delete on release
+ * struct bar : ref_counted<bar, plain_ref_count> { ... };       // single thread counting
+ * struct baz : ref_counted<baz, atomic_ref_count, pool_del> { ... };  // pool_del returns memory to a pool
+ *
+ * auto p = make_ref<foo>(args...);
+ */
+
+namespace lite_fnds {
+    // counting policies
+    struct atomic_ref_count {
+        using counter_t = std::atomic<size_t>;
+
+        static void increase(counter_t& c) noexcept {
+            c.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // returns true if the last reference has been dropped.
+        static bool decrease(counter_t& c) noexcept {
+            if (c.fetch_sub(1, std::memory_order_release) == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return true;
+            }
+            return false;
+        }
+
+        static size_t load(const counter_t& c) noexcept {
+            return c.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct plain_ref_count {
+        using counter_t = size_t;
+
+        static void increase(counter_t& c) noexcept {
+            ++c;
+        }
+
+        static bool decrease(counter_t& c) noexcept {
+            return --c == 0;
+        }
+
+        static size_t load(const counter_t& c) noexcept {
+            return c;
+        }
+    };
+
+    struct ref_default_delete {
+        template <typename T>
+        void operator()(T* p) const noexcept {
+            static_assert(sizeof(T) > 0, "attempting to delete an incomplete type");
+            delete p;
+        }
+    };
+
+    // Deleter must be stateless, it is default constructed on the last release.
+    // Use it to hand the memory back to a pool (or an aligned allocator) instead of delete.
+    template <typename Derived,
+        typename Policy = atomic_ref_count,
+        typename Deleter = ref_default_delete>
+    struct ref_counted {
+        static_assert(std::is_empty<Deleter>::value, "Deleter of ref_counted must be stateless");
+        static_assert(std::is_nothrow_default_constructible<Deleter>::value,
+            "Deleter of ref_counted must be nothrow default constructible");
+
+        using ref_policy = Policy;
+        using ref_deleter = Deleter;
+
+        ref_counted() noexcept
+            : ref_count_ { 0 } {
+        }
+
+        // the counter belongs to the object identity, it is never copied.
+        ref_counted(const ref_counted&) noexcept
+            : ref_count_ { 0 } {
+        }
+
+        ref_counted& operator=(const ref_counted&) noexcept {
+            return *this;
+        }
+
+        void add_ref() const noexcept {
+            Policy::increase(ref_count_);
+        }
+
+        void release() const noexcept {
+            if (Policy::decrease(ref_count_)) {
+                static_assert(noexcept(std::declval<Deleter&>()(std::declval<Derived*>())),
+                    "Deleter(Derived*) must be noexcept");
+                Deleter deleter;
+                deleter(static_cast<Derived*>(const_cast<ref_counted*>(this)));
+            }
+        }
+
+        size_t use_count() const noexcept {
+            return Policy::load(ref_count_);
+        }
+
+    protected:
+        ~ref_counted() noexcept = default;
+
+    private:
+        mutable typename Policy::counter_t ref_count_;
+    };
+
+    struct adopt_ref_t {
+        explicit adopt_ref_t() = default;
+    };
+
+    constexpr static adopt_ref_t adopt_ref{};
+
+    // T must provide add_ref() / release(), usually by inheriting ref_counted<T>
+    template <typename T>
+    class ref_ptr {
+        template <typename U>
+        friend class ref_ptr;
+
+        T* p_;
+
+    public:
+        using element_type = T;
+
+        constexpr ref_ptr() noexcept
+            : p_ { nullptr } {
+        }
+
+        constexpr ref_ptr(std::nullptr_t) noexcept
+            : p_ { nullptr } {
+        }
+
+        // shares ownership of p
+        explicit ref_ptr(T* p) noexcept
+            : p_ { p } {
+            if (p_) {
+                p_->add_ref();
+            }
+        }
+
+        // takes over a reference which was already counted for p
+        ref_ptr(T* p, adopt_ref_t) noexcept
+            : p_ { p } {
+        }
+
+        ref_ptr(const ref_ptr& rhs) noexcept
+            : p_ { rhs.p_ } {
+            if (p_) {
+                p_->add_ref();
+            }
+        }
+
+        ref_ptr(ref_ptr&& rhs) noexcept
+            : p_ { rhs.p_ } {
+            rhs.p_ = nullptr;
+        }
+
+        template <typename U, std::enable_if_t<std::is_convertible<U*, T*>::value>* = nullptr>
+        ref_ptr(const ref_ptr<U>& rhs) noexcept
+            : p_ { rhs.p_ } {
+            if (p_) {
+                p_->add_ref();
+            }
+        }
+
+        template <typename U, std::enable_if_t<std::is_convertible<U*, T*>::value>* = nullptr>
+        ref_ptr(ref_ptr<U>&& rhs) noexcept
+            : p_ { rhs.p_ } {
+            rhs.p_ = nullptr;
+        }
+
+        ~ref_ptr() noexcept {
+            if (p_) {
+                p_->release();
+            }
+        }
+
+        ref_ptr& operator=(const ref_ptr& rhs) noexcept {
+            ref_ptr tmp(rhs);
+            this->swap(tmp);
+            return *this;
+        }
+
+        ref_ptr& operator=(ref_ptr&& rhs) noexcept {
+            if (this != &rhs) {
+                ref_ptr tmp(std::move(rhs));
+                this->swap(tmp);
+            }
+            return *this;
+        }
+
+        ref_ptr& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        void reset() noexcept {
+            ref_ptr tmp;
+            this->swap(tmp);
+        }
+
+        void reset(T* p) noexcept {
+            ref_ptr tmp(p);
+            this->swap(tmp);
+        }
+
+        // gives up ownership without releasing, the caller owns one reference afterwards
+        T* detach() noexcept {
+            T* p = p_;
+            p_ = nullptr;
+            return p;
+        }
+
+        void swap(ref_ptr& rhs) noexcept {
+            using std::swap;
+            swap(p_, rhs.p_);
+        }
+
+        T* get() const noexcept {
+            return p_;
+        }
+
+        T& operator*() const noexcept {
+            assert(p_ && "attempting to dereference a null ref_ptr");
+            return *p_;
+        }
+
+        T* operator->() const noexcept {
+            assert(p_ && "attempting to dereference a null ref_ptr");
+            return p_;
+        }
+
+        explicit operator bool() const noexcept {
+            return p_ != nullptr;
+        }
+
+        size_t use_count() const noexcept {
+            return p_ ? p_->use_count() : 0;
+        }
+    };
+
+    template <typename T>
+    void swap(ref_ptr<T>& lhs, ref_ptr<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    template <typename T, typename U>
+    bool operator==(const ref_ptr<T>& lhs, const ref_ptr<U>& rhs) noexcept {
+        return lhs.get() == rhs.get();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ref_ptr<T>& lhs, const ref_ptr<U>& rhs) noexcept {
+        return lhs.get() != rhs.get();
+    }
+
+    template <typename T>
+    bool operator==(const ref_ptr<T>& lhs, std::nullptr_t) noexcept {
+        return !lhs;
+    }
+
+    template <typename T>
+    bool operator==(std::nullptr_t, const ref_ptr<T>& rhs) noexcept {
+        return !rhs;
+    }
+
+    template <typename T>
+    bool operator!=(const ref_ptr<T>& lhs, std::nullptr_t) noexcept {
+        return static_cast<bool>(lhs);
+    }
+
+    template <typename T>
+    bool operator!=(std::nullptr_t, const ref_ptr<T>& rhs) noexcept {
+        return static_cast<bool>(rhs);
+    }
+
+    // objects made here are released through their Deleter, which should match plain new.
+    template <typename T, typename... Args>
+    ref_ptr<T> make_ref(Args&&... args) {
+        return ref_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+}
+
+#endif
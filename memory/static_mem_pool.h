@@ -5,7 +5,8 @@
 #include "../base/traits.h"
 
 namespace lite_fnds {
-    template <size_t max_block_count = 16, size_t max_block_size = 512>
+    // Policy: thread_safe_policy (default) or thread_local_policy for a pool owned by one thread.
+    template <size_t max_block_count = 16, size_t max_block_size = 512, typename Policy = thread_safe_policy>
     struct static_mem_pool {
         static_assert((max_block_count & (max_block_count - 1)) == 0, 
             "max_block_count must be power of two");
@@ -18,7 +19,7 @@ namespace lite_fnds {
         alignas(std::max_align_t) uint8_t buff[epoch * line_width];
 
         template <size_t line>
-        using list_t = static_list<uint8_t*, (max_block_count << (maxoff - line))>;
+        using list_t = static_list<uint8_t*, (max_block_count << (maxoff - line)), Policy>;
 
         list_t<0> free_0;
         list_t<1> free_1;
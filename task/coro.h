@@ -0,0 +1,273 @@
+#ifndef LITE_FNDS_CORO_H
+#define LITE_FNDS_CORO_H
+
+#include "../base/traits.h"
+
+/**
+ * C++20 coroutine support, empty below C++20 (LFNDS_HAS_COROUTINES).
+ *
+ * lite_future<int> handle(request req) {             // a coroutine returning lite_future<T, E>
+ *     co_await schedule(&executor);                  // resumes as a task_wrapper_sbo on executor
+ *     auto a = co_await fetch(req);                  // lite_future<T, E> -> result_t<T, E>
+ *     auto b = co_await async_run(bp, a.value());    // one flow run -> the result_t of its end node
+ *     co_return b.value();                           // or co_return a result_t<int, E>
+ * }
+ *
+ * A lite_future coroutine starts eagerly and completes its future when it returns, an escaping
+ * exception becomes the error if E can be made from std::exception_ptr. Its frame comes from a
+ * static pool (pooled_frame, which any other promise_type may inherit as well), the heap only
+ * serves frames too big for the pool or once the pool is exhausted.
+ *
+ * An awaiting coroutine resumes on the thread which completes what it waits for, no hop of its
+ * own is allocated: the future continuation and the executor task hold just the handle, an awaited
+ * flow run carries a pointer to its awaiter through every hop.
+ */
+
+#if LFNDS_HAS_COROUTINES
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../base/inplace_base.h"
+#include "../flow/flow_runner.h"
+#include "../memory/static_mem_pool.h"
+#include "lite_future.h"
+#include "task_wrapper.h"
+
+namespace lite_fnds {
+    namespace coro_impl {
+        using frame_pool_t = static_mem_pool<32, 512>;
+
+        inline frame_pool_t& frame_pool() noexcept {
+            static frame_pool_t pool;
+            return pool;
+        }
+    }
+
+    // a promise_type base taking its coroutine frame from a static pool
+    struct pooled_frame {
+        static void* operator new(size_t n) {
+            void* p = coro_impl::frame_pool().allocate(n);
+            return p ? p : ::operator new(n);
+        }
+
+        static void operator delete(void* p) noexcept {
+            auto& pool = coro_impl::frame_pool();
+            if (pool.belong_to(p)) {
+                pool.deallocate(p);
+            } else {
+                ::operator delete(p);
+            }
+        }
+    };
+
+    namespace coro_impl {
+        template <typename T, typename E>
+        struct future_promise_base : pooled_frame {
+            lite_promise<T, E> promise;
+
+            lite_future<T, E> get_return_object() noexcept {
+                return promise.get_future();
+            }
+
+            std::suspend_never initial_suspend() const noexcept {
+                return {};
+            }
+
+            // the frame goes as soon as the body is done, the result lives in the future
+            std::suspend_never final_suspend() const noexcept {
+                return {};
+            }
+
+            void unhandled_exception() noexcept {
+                fail_current(std::is_constructible<E, std::exception_ptr> {});
+            }
+
+        private:
+            void fail_current(std::true_type) noexcept {
+                promise.set_error(E(std::current_exception()));
+            }
+
+            void fail_current(std::false_type) noexcept {
+                std::terminate();
+            }
+        };
+
+        template <typename T, typename E>
+        struct future_promise : future_promise_base<T, E> {
+            void return_value(result_t<T, E>&& r) {
+                this->promise.set_result(std::move(r));
+            }
+
+            template <typename U, std::enable_if_t<!is_result_t<U>::value>* = nullptr>
+            void return_value(U&& v) {
+                this->promise.set_value(std::forward<U>(v));
+            }
+        };
+
+        template <typename E>
+        struct future_promise<void, E> : future_promise_base<void, E> {
+            void return_void() noexcept {
+                this->promise.set_value();
+            }
+        };
+
+        template <typename T, typename E>
+        class future_awaiter {
+            ref_ptr<lite_future_impl::shared_state<T, E>> state;
+
+        public:
+            explicit future_awaiter(ref_ptr<lite_future_impl::shared_state<T, E>> s) noexcept
+                : state(std::move(s)) {
+            }
+
+            bool await_ready() const noexcept {
+                return state->ready();
+            }
+
+            // the continuation may resume h right here, nothing is touched after it
+            void await_suspend(std::coroutine_handle<> h) noexcept {
+                state->on_ready(task_wrapper_sbo([h]() noexcept {
+                    h.resume();
+                }));
+            }
+
+            result_t<T, E> await_resume() noexcept(std::is_nothrow_move_constructible<result_t<T, E>>::value) {
+                return std::move(state->result());
+            }
+        };
+
+        template <typename Executor>
+        struct schedule_awaiter {
+            Executor exec;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> h) noexcept {
+                exec->dispatch(task_wrapper_sbo([h]() noexcept {
+                    h.resume();
+                }));
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+    }
+
+    // co_await std::move(f) gives the result_t, the future is consumed
+    template <typename T, typename E>
+    auto operator co_await(lite_future<T, E>&& f) noexcept {
+        return coro_impl::future_awaiter<T, E>(lite_future_impl::future_access::take_state(f));
+    }
+
+    // continues the coroutine as a task on exec (pointer-like, exec->dispatch(task_wrapper_sbo&&))
+    template <typename Executor>
+    auto schedule(Executor exec) noexcept {
+        return coro_impl::schedule_awaiter<Executor> { std::move(exec) };
+    }
+
+    // starts one run of a blueprint when awaited and resumes with the result of its end node,
+    // on the thread which finishes the run.
+    template <typename flow_bp, typename bp_ptr_t>
+    class flow_run_awaiter : flow_completion {
+        using runner_t = flow_runner<flow_bp, bp_ptr_t, flow_impl::await_completion>;
+        using in_t = typename flow_bp::I_t::value_type;
+
+    public:
+        using result_type = typename std::tuple_element_t<0, typename flow_bp::storage_t>::O_t;
+
+    private:
+        bp_ptr_t bp;
+        in_t in;
+        flow_controller_ptr ctrl;
+        raw_inplace_storage_base<result_type> out;
+        bool done = false;
+        std::coroutine_handle<> h;
+
+        static void on_end(flow_completion* c, void* o) noexcept {
+            auto self = static_cast<flow_run_awaiter*>(c);
+            self->out.construct(std::move(*static_cast<result_type*>(o)));
+            self->done = true;
+            self->h.resume();
+        }
+
+        static void no_blueprint() {
+#if LFNDS_HAS_EXCEPTIONS
+            throw std::invalid_argument("async_run: the blueprint is null");
+#else
+            assert(false && "async_run: the blueprint is null");
+#endif
+        }
+
+    public:
+        // a null blueprint would never finish, so it is refused here rather than hanging the awaiter
+        flow_run_awaiter(bp_ptr_t bp_, in_t&& in_, flow_controller_ptr ctrl_)
+            : flow_completion { &flow_run_awaiter::on_end }
+            , bp(std::move(bp_))
+            , in(std::move(in_))
+            , ctrl(ctrl_ ? std::move(ctrl_) : make_controller()) {
+            if (!bp) {
+                no_blueprint();
+            }
+        }
+
+        flow_run_awaiter(const flow_run_awaiter&) = delete;
+        flow_run_awaiter& operator=(const flow_run_awaiter&) = delete;
+
+        ~flow_run_awaiter() noexcept {
+            if (done) {
+                out.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        // a run without a control node finishes (and resumes h) before the runner returns
+        void await_suspend(std::coroutine_handle<> h_) noexcept {
+            h = h_;
+            runner_t runner(bp, ctrl, flow_impl::await_completion { this });
+            runner(std::move(in));
+        }
+
+        result_type await_resume() noexcept(std::is_nothrow_move_constructible<result_type>::value) {
+            return std::move(*out.ptr());
+        }
+    };
+
+    // ctrl may cancel the run and may be shared with other runs, the result goes to this awaiter only
+    template <typename I_t, typename O_t, typename... Nodes, typename In>
+    auto async_run(std::shared_ptr<flow_impl::flow_blueprint<I_t, O_t, Nodes...>> bp, In&& in,
+        flow_controller_ptr ctrl = nullptr) {
+        using bp_t = flow_impl::flow_blueprint<I_t, O_t, Nodes...>;
+        return flow_run_awaiter<bp_t, std::shared_ptr<bp_t>>(std::move(bp),
+            typename I_t::value_type(std::forward<In>(in)), std::move(ctrl));
+    }
+
+    template <typename I_t, typename O_t, typename... Nodes, typename In>
+    auto async_run(ref_ptr<flow_impl::ref_blueprint<flow_impl::flow_blueprint<I_t, O_t, Nodes...>>> bp, In&& in,
+        flow_controller_ptr ctrl = nullptr) {
+        using bp_t = flow_impl::flow_blueprint<I_t, O_t, Nodes...>;
+        using bp_ptr = ref_ptr<flow_impl::ref_blueprint<bp_t>>;
+        return flow_run_awaiter<bp_t, bp_ptr>(std::move(bp),
+            typename I_t::value_type(std::forward<In>(in)), std::move(ctrl));
+    }
+}
+
+template <typename T, typename E, typename... Args>
+struct std::coroutine_traits<lite_fnds::lite_future<T, E>, Args...> {
+    using promise_type = lite_fnds::coro_impl::future_promise<T, E>;
+};
+
+#endif
+
+#endif
@@ -5,49 +5,78 @@
 #include <atomic>
 #include "../base/traits.h"
 #include "task_core.h"
+#include "lite_future.h"
 
 namespace lite_fnds {
 
 namespace future_task_detail {
-    template <typename Callable, typename... Params>
-    class future_task_impl : task<std::decay_t<Callable>, std::decay_t<Params>...> {
-        using base = task<std::decay_t<Callable>, std::decay_t<Params>...>;
-
-        base& _as_base() noexcept {
-            return static_cast<base&>(*this);
-        }
-
-        void run(std::false_type, std::false_type) noexcept {
-            auto result = _as_base()();
+    // how the result of a task reaches its promise: through std::promise<R> ...
+    template <typename R>
+    struct std_promise_policy {
+        using promise_type = std::promise<R>;
+        using future_type = std::future<R>;
+
+        template <typename Res>
+        static void fulfill(std::false_type, std::false_type, promise_type& promise, Res&& result) noexcept {
             if (result.has_value()) {
-                promise_.set_value(std::move(result.value()));
-            } 
+                promise.set_value(std::move(result.value()));
+            }
 #if LFNDS_COMPILER_HAS_EXCEPTIONS
               else {
-                promise_.set_exception(result.error());
+                promise.set_exception(result.error());
             }
 #endif
         }
 
-        void run(std::true_type, std::false_type) noexcept {
-            auto result = _as_base()();
+        template <typename Res>
+        static void fulfill(std::true_type, std::false_type, promise_type& promise, Res&& result) noexcept {
             if (result.has_value()) {
-                promise_.set_value();
+                promise.set_value();
             }
 #if LFNDS_COMPILER_HAS_EXCEPTIONS
               else {
-                promise_.set_exception(result.error());
+                promise.set_exception(result.error());
             }
 #endif
         }
 
-        void run(std::false_type, std::true_type) noexcept {
-            promise_.set_value(_as_base()());
+        template <typename Res>
+        static void fulfill(std::false_type, std::true_type, promise_type& promise, Res&& result) noexcept {
+            promise.set_value(std::forward<Res>(result));
+        }
+
+        template <typename Res>
+        static void fulfill(promise_type& promise, Res&& result) noexcept {
+            fulfill(std::is_void<R> {}, is_result_t<R> {}, promise, std::forward<Res>(result));
+        }
+    };
+
+    // ... or through a lite_promise carrying the task's result_t as is.
+    template <typename R>
+    struct lite_promise_policy {
+        using promise_type = lite_promise_for_t<task_impl_private::uniform_result_t<R>>;
+        using future_type = typename promise_type::future_type;
+
+        template <typename Res>
+        static void fulfill(promise_type& promise, Res&& result) noexcept {
+            promise.set_result(std::forward<Res>(result));
+        }
+    };
+
+    template <template <typename> class Policy, typename Callable, typename... Params>
+    class future_task_impl : task<std::decay_t<Callable>, std::decay_t<Params>...> {
+        using base = task<std::decay_t<Callable>, std::decay_t<Params>...>;
+        using policy = Policy<typename base::callable_result_t>;
+        using promise_type = typename policy::promise_type;
+
+        base& _as_base() noexcept {
+            return static_cast<base&>(*this);
         }
 
     public:
         using base::base;
         using result_type = typename base::callable_result_t;
+        using future_type = typename policy::future_type;
 
         future_task_impl() = delete;
 
@@ -56,7 +85,7 @@ namespace future_task_detail {
 
         future_task_impl(future_task_impl&& other) noexcept(conjunction_v<
             std::is_nothrow_move_constructible<base>,
-            std::is_nothrow_move_constructible<std::promise<result_type>>>)
+            std::is_nothrow_move_constructible<promise_type>>)
             : base(std::move(static_cast<base&>(other)))
             , promise_(std::move(other.promise_))
             , fired_(other.fired_.load(std::memory_order_relaxed)) {
@@ -64,7 +93,7 @@ namespace future_task_detail {
 
         future_task_impl& operator=(future_task_impl&& other) 
             noexcept(conjunction_v<std::is_nothrow_move_assignable<base>,
-                    std::is_nothrow_move_assignable<std::promise<result_type>>>) {
+                    std::is_nothrow_move_assignable<promise_type>>) {
             if (this != &other) {
                 static_cast<base&>(*this) = std::move(static_cast<base&>(other));
                 promise_ = std::move(other.promise_);
@@ -73,7 +102,7 @@ namespace future_task_detail {
             return *this;
         }
 
-        std::future<result_type> get_future() {
+        future_type get_future() {
             return this->promise_.get_future();
         }
 
@@ -82,43 +111,52 @@ namespace future_task_detail {
             if (fired_.exchange(true, std::memory_order_relaxed)) {
                 return;
             }
-            this->run(std::is_void<result_type> {}, is_result_t<result_type>{});
+            policy::fulfill(promise_, _as_base()());
         }
 
     private:
-        std::promise<result_type> promise_;
+        promise_type promise_;
         std::atomic<bool> fired_ { false };
     };
 }
 
 // it's your responsibility to guarantee not to call get_future more than once.
-template <typename Callable, typename... Params>
-class future_task : 
-    public future_task_detail::future_task_impl<Callable, Params...>,
-    private ctor_delete_base<future_task<Callable, Params...>, false,
+template <template <typename> class Policy, typename Callable, typename... Params>
+class basic_future_task : 
+    public future_task_detail::future_task_impl<Policy, Callable, Params...>,
+    private ctor_delete_base<basic_future_task<Policy, Callable, Params...>, false,
 #if LFNDS_HAS_EXCEPTIONS
         true              
 #else
         std::is_nothrow_move_constructible<
-           future_task_detail::future_task_impl<Callable, Params...>
+           future_task_detail::future_task_impl<Policy, Callable, Params...>
         >::value
 #endif
     >,
-    private assign_delete_base<future_task<Callable, Params...>, false,
+    private assign_delete_base<basic_future_task<Policy, Callable, Params...>, false,
 #if LFNDS_HAS_EXCEPTIONS
         true
 #else
         std::is_nothrow_move_assignable<
-            future_task_detail::future_task_impl<Callable, Params...>
+            future_task_detail::future_task_impl<Policy, Callable, Params...>
         >::value
 #endif
      > {
-    using impl = future_task_detail::future_task_impl<Callable, Params...>;
+    using impl = future_task_detail::future_task_impl<Policy, Callable, Params...>;
 public:
     using impl::impl;
     using result_type = typename impl::result_type;
+    using future_type = typename impl::future_type;
 };
 
+// get_future() returns a lite_future<T, E> holding the task's result_t.
+template <typename Callable, typename... Params>
+using future_task = basic_future_task<future_task_detail::lite_promise_policy, Callable, Params...>;
+
+// get_future() returns a std::future<R>.
+template <typename Callable, typename... Params>
+using std_future_task = basic_future_task<future_task_detail::std_promise_policy, Callable, Params...>;
+
 template <typename Callable, typename... Args>
 auto make_future_task(Callable&& callable, Args&&... args) 
     noexcept(std::is_nothrow_constructible<
@@ -129,6 +167,16 @@ auto make_future_task(Callable&& callable, Args&&... args)
         std::forward<Callable>(callable), std::forward<Args>(args)...);
 }
 
+template <typename Callable, typename... Args>
+auto make_std_future_task(Callable&& callable, Args&&... args) 
+    noexcept(std::is_nothrow_constructible<
+        std_future_task<std::decay_t<Callable>, std::decay_t<Args>...>,
+        Callable&&, Args&&...>::value)
+    -> std_future_task<std::decay_t<Callable>, std::decay_t<Args>...> {
+    return std_future_task<std::decay_t<Callable>, std::decay_t<Args>...>(
+        std::forward<Callable>(callable), std::forward<Args>(args)...);
+}
+
 }
 
 #endif
@@ -0,0 +1,546 @@
+#ifndef LITE_FNDS_LITE_FUTURE_H
+#define LITE_FNDS_LITE_FUTURE_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#include "../base/traits.h"
+#include "../base/inplace_base.h"
+#include "../memory/ref_ptr.h"
+#include "../memory/result_t.h"
+#include "../memory/static_mem_pool.h"
+#include "../utility/yield.h"
+#include "task_wrapper.h"
+
+/**
+ * Single-shot lite_promise<T, E> / lite_future<T, E>, a cheap replacement for std::promise/std::future.
+ *
+ * lite_promise<int> p;
+ * auto f = p.get_future();
+ * p.set_value(42);                     // or set_error(e), set_result(result_t<int, E>)
+ * result_t<int, E> r = f.get();        // blocks until the promise is satisfied
+ *
+ * The shared state is one reference counted block taken from a static pool (the heap once the pool
+ * is exhausted), it holds the result_t and a 32 bit state word. Completion is a single atomic or,
+ * a waiter spins shortly and then parks on a futex (a condition variable off Linux), the setter only
+ * wakes anyone if somebody parks.
+ * A promise destroyed without a result completes the future with broken_promise<E>::make().
+ *
+ * auto g = f.then([](result_t<int, E> r) { return r.value() * 2; });        // lite_future<int, E>
+ * auto h = g.then(&executor, [](result_t<int, E> r) noexcept { ... });     // runs as an executor task
+ *
+ * A continuation runs inline on the thread completing the promise (or right away if the result is
+ * already there), then(executor, f) dispatches it as a task_wrapper_sbo instead. It is kept in the
+ * shared state, small ones do not allocate.
+ */
+
+namespace lite_fnds {
+    // the error a future receives when its promise is gone without a result.
+    template <typename E>
+    struct broken_promise {
+        static E make() noexcept(std::is_nothrow_default_constructible<E>::value) {
+            return E {};
+        }
+    };
+
+    template <>
+    struct broken_promise<std::exception_ptr> {
+        static std::exception_ptr make() noexcept {
+            return std::make_exception_ptr(std::logic_error("lite_promise destroyed without a result"));
+        }
+    };
+
+    namespace lite_future_impl {
+        enum state_bits : uint32_t {
+            st_ready = 1,
+            st_waiting = 2,
+            st_continuation = 4,
+        };
+
+        // polls of the state word before a waiter parks
+        static constexpr size_t spin_count = 128;
+
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "a futex word must be a plain uint32_t");
+
+#ifdef __linux__
+        // returns once the word no longer holds expected, on a timeout, or spuriously.
+        inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, const timespec* rel = nullptr) noexcept {
+            (void)syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, rel, nullptr, 0);
+        }
+
+        inline void futex_wake_all(std::atomic<uint32_t>& word) noexcept {
+            (void)syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+        }
+#else
+        // no futex: waiters park on the condition variable of a small table, picked by the word's address.
+        struct park_bucket {
+            std::mutex mtx;
+            std::condition_variable cv;
+        };
+
+        inline park_bucket& bucket_of(const void* p) noexcept {
+            static park_bucket buckets[16];
+            return buckets[(reinterpret_cast<uintptr_t>(p) / CACHE_LINE_SIZE) % 16];
+        }
+
+        // the word is checked under the bucket lock, which the waker takes before it notifies.
+        inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected,
+            const std::chrono::nanoseconds* rel = nullptr) noexcept {
+            auto& b = bucket_of(&word);
+            std::unique_lock<std::mutex> lk(b.mtx);
+            if (word.load(std::memory_order_acquire) != expected) {
+                return;
+            }
+            if (rel) {
+                b.cv.wait_for(lk, *rel);
+            } else {
+                b.cv.wait(lk);
+            }
+        }
+
+        inline void futex_wake_all(std::atomic<uint32_t>& word) noexcept {
+            auto& b = bucket_of(&word);
+            {
+                std::lock_guard<std::mutex> lk(b.mtx);
+            }
+            b.cv.notify_all();
+        }
+#endif
+
+        using state_pool_t = static_mem_pool<64, 256>;
+
+        inline state_pool_t& state_pool() noexcept {
+            static state_pool_t pool;
+            return pool;
+        }
+
+        inline void* allocate_state(size_t n) noexcept {
+            void* p = state_pool().allocate(n);
+            return p ? p : ::operator new(n, std::nothrow);
+        }
+
+        inline void deallocate_state(void* p) noexcept {
+            auto& pool = state_pool();
+            if (pool.belong_to(p)) {
+                pool.deallocate(p);
+            } else {
+                ::operator delete(p);
+            }
+        }
+
+        struct state_delete {
+            template <typename S>
+            void operator()(S* p) const noexcept {
+                p->~S();
+                deallocate_state(p);
+            }
+        };
+
+        template <typename T, typename E>
+        struct shared_state : ref_counted<shared_state<T, E>, atomic_ref_count, state_delete> {
+            using result_type = result_t<T, E>;
+            static_assert(std::is_nothrow_destructible<result_type>::value, "result_t<T, E> must be nothrow destructible");
+
+            std::atomic<uint32_t> word { 0 };
+            raw_inplace_storage_base<result_type> storage;
+            // owned by the future until st_continuation is published, by whoever runs it afterwards.
+            task_wrapper_sbo continuation;
+
+            shared_state() noexcept = default;
+            shared_state(const shared_state&) = delete;
+            shared_state& operator=(const shared_state&) = delete;
+
+            ~shared_state() noexcept {
+                if (word.load(std::memory_order_relaxed) & st_ready) {
+                    storage.destroy();
+                }
+            }
+
+            bool ready() const noexcept {
+                return (word.load(std::memory_order_acquire) & st_ready) != 0;
+            }
+
+            result_type& result() noexcept {
+                return *storage.ptr();
+            }
+
+            // only the promise sets, once
+            template <typename... Args>
+            void set(Args&&... args) noexcept(std::is_nothrow_constructible<result_type, Args&&...>::value) {
+                storage.construct(std::forward<Args>(args)...);
+                complete();
+            }
+
+            void complete() noexcept {
+                auto old = word.fetch_or(st_ready, std::memory_order_acq_rel);
+                assert(!(old & st_ready) && "the result of a lite_promise is set more than once");
+                UNLIKELY_IF(old & st_waiting) {
+                    futex_wake_all(word);
+                }
+                if (old & st_continuation) {
+                    run_continuation();
+                }
+            }
+
+            // whichever of complete() and on_ready() sets its bit second runs the continuation.
+            void on_ready(task_wrapper_sbo&& c) noexcept {
+                if (ready()) {
+                    c();
+                    return;
+                }
+
+                continuation = std::move(c);
+                auto old = word.fetch_or(st_continuation, std::memory_order_acq_rel);
+                if (old & st_ready) {
+                    run_continuation();
+                }
+            }
+
+            // the continuation may hold the last reference to this state, nothing is touched after it.
+            void run_continuation() noexcept {
+                task_wrapper_sbo c(std::move(continuation));
+                c();
+            }
+
+            // announces a parked waiter, false if the result arrived meanwhile.
+            bool prepare_park(uint32_t& w) noexcept {
+                while (!(w & st_waiting)) {
+                    if (w & st_ready) {
+                        return false;
+                    }
+                    if (word.compare_exchange_weak(w, w | st_waiting,
+                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+                        w |= st_waiting;
+                    }
+                }
+                return !(w & st_ready);
+            }
+
+            void wait() noexcept {
+                for (size_t i = 0; i < spin_count; ++i) {
+                    LIKELY_IF(ready()) {
+                        return;
+                    }
+                    yield();
+                }
+
+                uint32_t w = word.load(std::memory_order_acquire);
+                while (prepare_park(w)) {
+                    futex_wait(word, w);
+                    w = word.load(std::memory_order_acquire);
+                }
+            }
+
+            template <typename Clock, typename Duration>
+            bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+                uint32_t w = word.load(std::memory_order_acquire);
+                while (prepare_park(w)) {
+                    auto now = Clock::now();
+                    if (now >= deadline) {
+                        return false;
+                    }
+#ifdef __linux__
+                    auto rel = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+                    timespec ts;
+                    ts.tv_sec = static_cast<time_t>(rel.count() / 1000000000);
+                    ts.tv_nsec = static_cast<long>(rel.count() % 1000000000);
+                    futex_wait(word, w, &ts);
+#else
+                    auto rel = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+                    futex_wait(word, w, &rel);
+#endif
+                    w = word.load(std::memory_order_acquire);
+                }
+                return true;
+            }
+        };
+
+        // f(result_t<T, E>&&) returning R gives a result_t<R, E>, unless R already is a result_t
+        template <typename F, typename Res>
+        struct then_result {
+            using R = invoke_result_t<F, Res&&>;
+            using type = typename std::conditional_t<is_result_t<R>::value,
+                type_identity<R>, type_identity<result_t<R, typename Res::error_type>>>::type;
+        };
+
+        template <typename F, typename Res>
+        using then_result_t = typename then_result<F, Res>::type;
+
+        template <typename P, typename F, typename Res>
+        void fulfill(std::true_type /*void*/, std::false_type, P& p, F& f, Res&& r) {
+            f(std::forward<Res>(r));
+            p.set_value();
+        }
+
+        template <typename P, typename F, typename Res>
+        void fulfill(std::false_type, std::false_type, P& p, F& f, Res&& r) {
+            p.set_value(f(std::forward<Res>(r)));
+        }
+
+        template <typename P, typename F, typename Res>
+        void fulfill(std::false_type, std::true_type /*result_t*/, P& p, F& f, Res&& r) {
+            p.set_result(f(std::forward<Res>(r)));
+        }
+
+        template <typename P>
+        void fail_current(std::true_type, P& p) noexcept {
+            p.set_error(std::current_exception());
+        }
+
+        template <typename P>
+        void fail_current(std::false_type, P&) noexcept {
+            std::terminate();
+        }
+
+        // runs f on the result of the previous future and completes the next one with it.
+        template <typename P, typename F, typename Res>
+        void invoke_continuation(P& p, F& f, Res&& r) noexcept {
+            using R = invoke_result_t<F, Res&&>;
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+            try {
+#endif
+                fulfill(std::is_void<R> {}, is_result_t<R> {}, p, f, std::forward<Res>(r));
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+            } catch (...) {
+                // a throwing f is reported through the next future if its error type can carry it.
+                fail_current(std::is_convertible<std::exception_ptr, typename P::error_type> {}, p);
+            }
+#endif
+        }
+
+        // S derives from ref_counted<S, atomic_ref_count, state_delete>
+        template <typename S, typename... Args>
+        ref_ptr<S> make_block(Args&&... args) {
+            static_assert(alignof(S) <= alignof(std::max_align_t), "the state pool only serves max_align_t");
+
+            void* mem = allocate_state(sizeof(S));
+#if LFNDS_HAS_EXCEPTIONS
+            if (!mem) {
+                throw std::bad_alloc();
+            }
+#else
+            assert(mem && "lite_promise: failed to allocate the shared state");
+#endif
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+            // a join block builds a promise (and reserves room) of its own, which may throw
+            try {
+                return ref_ptr<S>(::new (mem) S(std::forward<Args>(args)...));
+            } catch (...) {
+                deallocate_state(mem);
+                throw;
+            }
+#else
+            return ref_ptr<S>(::new (mem) S(std::forward<Args>(args)...));
+#endif
+        }
+
+        template <typename T, typename E>
+        ref_ptr<shared_state<T, E>> make_state() {
+            return make_block<shared_state<T, E>>();
+        }
+
+        // lets the combinators (when_all, when_any) take the state out of a future
+        struct future_access {
+            template <typename Future>
+            static auto take_state(Future& f) noexcept {
+                assert(f.valid() && "lite_future has no state");
+                return std::move(f.state_);
+            }
+        };
+    }
+
+    template <typename T, typename E = std::exception_ptr>
+    class lite_promise;
+
+    // the promise type which carries a given result_t<T, E>
+    template <typename R>
+    struct lite_promise_for;
+
+    template <typename T, typename E>
+    struct lite_promise_for<result_t<T, E>> : type_identity<lite_promise<T, E>> {};
+
+    template <typename R>
+    using lite_promise_for_t = typename lite_promise_for<R>::type;
+
+    template <typename T, typename E = std::exception_ptr>
+    class lite_future {
+        using state_t = lite_future_impl::shared_state<T, E>;
+
+        template <typename T_, typename E_>
+        friend class lite_promise;
+        friend struct lite_future_impl::future_access;
+
+        ref_ptr<state_t> state_;
+
+        explicit lite_future(ref_ptr<state_t> s) noexcept
+            : state_(std::move(s)) {
+        }
+
+    public:
+        using value_type = T;
+        using error_type = E;
+        using result_type = result_t<T, E>;
+
+        lite_future() noexcept = default;
+        lite_future(lite_future&&) noexcept = default;
+        lite_future& operator=(lite_future&&) noexcept = default;
+        lite_future(const lite_future&) = delete;
+        lite_future& operator=(const lite_future&) = delete;
+
+        // false once get() has been called
+        bool valid() const noexcept {
+            return static_cast<bool>(state_);
+        }
+
+        bool is_ready() const noexcept {
+            assert(valid() && "lite_future has no state");
+            return state_->ready();
+        }
+
+        void wait() const noexcept {
+            assert(valid() && "lite_future has no state");
+            state_->wait();
+        }
+
+        template <typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period>& rel) const noexcept {
+            return wait_until(std::chrono::steady_clock::now() + rel);
+        }
+
+        template <typename Clock, typename Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) const noexcept {
+            assert(valid() && "lite_future has no state");
+            return state_->wait_until(deadline);
+        }
+
+        // waits and moves the result out, the future is invalid afterwards.
+        result_type get() noexcept(std::is_nothrow_move_constructible<result_type>::value) {
+            wait();
+            auto s = std::move(state_);
+            return std::move(s->result());
+        }
+
+        // f(result_t<T, E>) runs once the result is there, on the completing thread.
+        // The future is invalid afterwards, the returned one carries f's result.
+        template <typename F, typename Next = lite_future_impl::then_result_t<std::decay_t<F>&, result_type>>
+        typename lite_promise_for_t<Next>::future_type then(F&& f) {
+            assert(valid() && "lite_future has no state");
+            lite_promise_for_t<Next> next;
+            auto res = next.get_future();
+
+            state_t* s = state_.get();
+            s->on_ready(task_wrapper_sbo([src = std::move(state_), next = std::move(next),
+                                             f = std::decay_t<F>(std::forward<F>(f))]() mutable noexcept {
+                lite_future_impl::invoke_continuation(next, f, std::move(src->result()));
+            }));
+            return res;
+        }
+
+        // the same, but f runs as a task dispatched to exec (pointer-like, exec->dispatch(task_wrapper_sbo)).
+        template <typename Executor, typename F,
+            typename Next = lite_future_impl::then_result_t<std::decay_t<F>&, result_type>>
+        typename lite_promise_for_t<Next>::future_type then(Executor exec, F&& f) {
+            assert(valid() && "lite_future has no state");
+            lite_promise_for_t<Next> next;
+            auto res = next.get_future();
+
+            state_t* s = state_.get();
+            auto run = [src = std::move(state_), next = std::move(next),
+                           f = std::decay_t<F>(std::forward<F>(f))]() mutable noexcept {
+                lite_future_impl::invoke_continuation(next, f, std::move(src->result()));
+            };
+            s->on_ready(task_wrapper_sbo([exec = std::move(exec), run = std::move(run)]() mutable noexcept {
+                exec->dispatch(task_wrapper_sbo(std::move(run)));
+            }));
+            return res;
+        }
+    };
+
+    template <typename T, typename E>
+    class lite_promise {
+        using state_t = lite_future_impl::shared_state<T, E>;
+
+        ref_ptr<state_t> state_;
+        bool retrieved_ = false;
+
+        void abandon() noexcept {
+            if (state_ && !state_->ready()) {
+                state_->set(error_tag, broken_promise<E>::make());
+            }
+        }
+
+    public:
+        using value_type = T;
+        using error_type = E;
+        using result_type = result_t<T, E>;
+        using future_type = lite_future<T, E>;
+
+        lite_promise()
+            : state_(lite_future_impl::make_state<T, E>()) {
+        }
+
+        lite_promise(lite_promise&& rhs) noexcept
+            : state_(std::move(rhs.state_))
+            , retrieved_(rhs.retrieved_) {
+        }
+
+        lite_promise& operator=(lite_promise&& rhs) noexcept {
+            if (this != &rhs) {
+                abandon();
+                state_ = std::move(rhs.state_);
+                retrieved_ = rhs.retrieved_;
+            }
+            return *this;
+        }
+
+        lite_promise(const lite_promise&) = delete;
+        lite_promise& operator=(const lite_promise&) = delete;
+
+        ~lite_promise() noexcept {
+            abandon();
+        }
+
+        // at most once
+        future_type get_future() noexcept {
+            assert(state_ && !retrieved_ && "lite_promise: the future is already retrieved");
+            retrieved_ = true;
+            return future_type(state_);
+        }
+
+        template <typename... Args>
+        void set_value(Args&&... args)
+            noexcept(std::is_nothrow_constructible<result_type, in_place_index<0>, Args&&...>::value) {
+            assert(state_ && "lite_promise has no state");
+            state_->set(value_tag, std::forward<Args>(args)...);
+        }
+
+        void set_error(E e) noexcept(std::is_nothrow_constructible<result_type, in_place_index<1>, E&&>::value) {
+            assert(state_ && "lite_promise has no state");
+            state_->set(error_tag, std::move(e));
+        }
+
+        void set_result(result_type&& r) noexcept(std::is_nothrow_move_constructible<result_type>::value) {
+            assert(state_ && "lite_promise has no state");
+            state_->set(std::move(r));
+        }
+    };
+}
+
+#endif
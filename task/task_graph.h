@@ -0,0 +1,316 @@
+#ifndef LITE_FNDS_TASK_GRAPH_H
+#define LITE_FNDS_TASK_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../base/inplace_base.h"
+#include "../base/traits.h"
+#include "../memory/result_t.h"
+#include "lite_future.h"
+#include "task_wrapper.h"
+
+/**
+ * task_graph<E>: a dependency graph of tasks built at runtime, run on any executor taking
+ * task_wrapper_sbo (exec->dispatch(task_wrapper_sbo&&)).
+ *
+ * task_graph<> g;
+ * auto parse = g.add(make_task(parse_file, std::move(path)), 4);   // cost 4, default 1
+ * auto link  = g.add([] { ... });
+ * g.precede(parse, link);                                         // parse runs before link
+ * auto done = g.run(&executor);                                   // lite_future<void, E>
+ * done.get();
+ *
+ * run() lays the successor lists out in one arena and gives every node an atomic count of its
+ * pending predecessors, a node becomes runnable when its count drops to zero. Every node also gets
+ * a rank, its cost plus the largest rank among its successors (the length of the critical path
+ * starting at it). Roots are dispatched by rank, a finishing node dispatches its ready successors
+ * by rank and keeps the highest one on its own thread, so the longest chain never waits in a queue.
+ * Nothing takes a lock, the only shared writes are the counters.
+ *
+ * A node may return void or a result_t, the first error (or exception, if E can be made from
+ * std::exception_ptr) fails the run: the nodes not started yet are skipped and the future gets
+ * that error. The graph is built from one thread, must not change while it runs and has to outlive
+ * the run. It can be run again once the future is ready.
+ */
+
+namespace lite_fnds {
+    template <typename E = std::exception_ptr>
+    class task_graph {
+    public:
+        using node_id = uint32_t;
+        using error_type = E;
+        using future_type = lite_future<void, E>;
+
+    private:
+        static constexpr node_id npos = static_cast<node_id>(-1);
+
+        std::vector<task_wrapper_sbo> works;
+        std::vector<uint32_t> costs;
+        std::vector<std::pair<node_id, node_id>> edges;
+
+        // per run
+        // offsets [0, n] then the successors, each list sorted by rank, highest first
+        std::unique_ptr<uint32_t[]> arena;
+        std::unique_ptr<std::atomic<uint32_t>[]> pending;
+        std::atomic<size_t> remaining { 0 };
+        std::atomic<bool> failed { false };
+        raw_inplace_storage_base<E> first_error;
+        // built by run(), so an idle graph holds no shared state
+        raw_inplace_storage_base<lite_promise<void, E>> done;
+
+        const uint32_t* succ_begin(node_id i) const noexcept {
+            return arena.get() + works.size() + 1 + arena[i];
+        }
+
+        const uint32_t* succ_end(node_id i) const noexcept {
+            return arena.get() + works.size() + 1 + arena[i + 1];
+        }
+
+        template <typename F>
+        void invoke(F& f) noexcept {
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+            try {
+#endif
+                call(std::is_void<invoke_result_t<F&>> {}, f);
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+            } catch (...) {
+                fail_current(std::is_constructible<E, std::exception_ptr> {});
+            }
+#endif
+        }
+
+        template <typename F>
+        void call(std::true_type /*void*/, F& f) {
+            f();
+        }
+
+        template <typename F>
+        void call(std::false_type, F& f) {
+            collect(f());
+        }
+
+        template <typename R, std::enable_if_t<is_result_t<R>::value>* = nullptr>
+        void collect(R&& r) noexcept {
+            static_assert(std::is_constructible<E, typename std::decay_t<R>::error_type&&>::value,
+                "the error type of a node must convert to the error type of the graph");
+            if (r.has_error()) {
+                fail(E(std::move(r.error())));
+            }
+        }
+
+        template <typename R, std::enable_if_t<!is_result_t<R>::value>* = nullptr>
+        void collect(R&&) noexcept {
+        }
+
+        void fail_current(std::true_type) noexcept {
+            fail(E(std::current_exception()));
+        }
+
+        void fail_current(std::false_type) noexcept {
+            std::terminate();
+        }
+
+        // the first error wins, the finishing node publishes it through remaining
+        void fail(E&& e) noexcept {
+            if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                first_error.construct(std::move(e));
+            }
+        }
+
+        template <typename Executor>
+        void dispatch(const Executor& exec, node_id i) noexcept {
+            exec->dispatch(task_wrapper_sbo([this, exec, i]() noexcept {
+                execute(exec, i);
+            }));
+        }
+
+        // runs i, then keeps going with its highest ranked successor which became ready
+        template <typename Executor>
+        void execute(const Executor& exec, node_id i) noexcept {
+            for (;;) {
+                LIKELY_IF(!failed.load(std::memory_order_acquire)) {
+                    works[i]();
+                }
+
+                node_id next = npos;
+                for (auto s = succ_begin(i), e = succ_end(i); s != e; ++s) {
+                    if (pending[*s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        if (next == npos) {
+                            next = *s;
+                        } else {
+                            dispatch(exec, *s);
+                        }
+                    }
+                }
+
+                // next has not finished yet, so this can't be the last node when next is set
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    finish();
+                    return;
+                }
+
+                if (next == npos) {
+                    return;
+                }
+                i = next;
+            }
+        }
+
+        // the graph may be gone as soon as the promise is set
+        void finish() noexcept {
+            auto p = std::move(*done.ptr());
+            done.destroy();
+            if (failed.load(std::memory_order_relaxed)) {
+                E e(std::move(*first_error.ptr()));
+                first_error.destroy();
+                p.set_error(std::move(e));
+            } else {
+                p.set_value();
+            }
+        }
+
+        static void cyclic() {
+#if LFNDS_HAS_EXCEPTIONS
+            throw std::logic_error("task_graph: the dependencies form a cycle");
+#else
+            assert(false && "task_graph: the dependencies form a cycle");
+#endif
+        }
+
+        // lays out the successor lists and returns the roots, highest rank first
+        std::vector<node_id> prepare() {
+            const size_t n = works.size();
+            const size_t m = edges.size();
+
+            arena.reset(new uint32_t[n + 1 + m]);
+            uint32_t* offs = arena.get();
+            uint32_t* succ = offs + n + 1;
+
+            std::fill(offs, offs + n + 1, 0u);
+            for (auto& e : edges) {
+                ++offs[e.first + 1];
+            }
+            for (size_t i = 0; i < n; ++i) {
+                offs[i + 1] += offs[i];
+            }
+
+            std::vector<uint32_t> fill(offs, offs + n);
+            std::vector<uint32_t> in_degree(n, 0);
+            for (auto& e : edges) {
+                succ[fill[e.first]++] = e.second;
+                ++in_degree[e.second];
+            }
+
+            // Kahn's order, then the ranks from the sinks backwards
+            std::vector<node_id> order;
+            order.reserve(n);
+            std::vector<uint32_t> left(in_degree);
+            for (node_id i = 0; i < n; ++i) {
+                if (!left[i]) {
+                    order.push_back(i);
+                }
+            }
+            for (size_t k = 0; k < order.size(); ++k) {
+                for (auto s = succ + offs[order[k]], e = succ + offs[order[k] + 1]; s != e; ++s) {
+                    if (--left[*s] == 0) {
+                        order.push_back(*s);
+                    }
+                }
+            }
+            if (order.size() != n) {
+                cyclic();
+            }
+
+            std::vector<uint64_t> rank(n, 0);
+            for (size_t k = n; k-- > 0;) {
+                node_id i = order[k];
+                uint64_t longest = 0;
+                for (auto s = succ + offs[i], e = succ + offs[i + 1]; s != e; ++s) {
+                    longest = std::max(longest, rank[*s]);
+                }
+                rank[i] = costs[i] + longest;
+            }
+
+            auto by_rank = [&rank](node_id a, node_id b) {
+                return rank[a] > rank[b];
+            };
+            for (size_t i = 0; i < n; ++i) {
+                std::sort(succ + offs[i], succ + offs[i + 1], by_rank);
+            }
+
+            pending.reset(new std::atomic<uint32_t>[n]);
+            std::vector<node_id> roots;
+            for (node_id i = 0; i < n; ++i) {
+                pending[i].store(in_degree[i], std::memory_order_relaxed);
+                if (!in_degree[i]) {
+                    roots.push_back(i);
+                }
+            }
+            std::sort(roots.begin(), roots.end(), by_rank);
+            return roots;
+        }
+
+    public:
+        task_graph() = default;
+        task_graph(const task_graph&) = delete;
+        task_graph& operator=(const task_graph&) = delete;
+
+        // f is invoked without arguments and may return void or a result_t,
+        // cost is its weight on the critical path.
+        template <typename F>
+        node_id add(F&& f, uint32_t cost = 1) {
+            assert(works.size() < npos && "task_graph: too many nodes");
+            works.emplace_back([this, f = std::decay_t<F>(std::forward<F>(f))]() mutable noexcept {
+                invoke(f);
+            });
+            costs.push_back(cost);
+            return static_cast<node_id>(works.size() - 1);
+        }
+
+        // a runs (and finishes) before b
+        void precede(node_id a, node_id b) {
+            assert(a < works.size() && b < works.size() && "task_graph: unknown node");
+            assert(a != b && "task_graph: a node can't precede itself");
+            edges.emplace_back(a, b);
+        }
+
+        size_t size() const noexcept {
+            return works.size();
+        }
+
+        // dispatches the roots to exec (pointer-like, exec->dispatch(task_wrapper_sbo&&)),
+        // the future is ready once every node has run or been skipped.
+        template <typename Executor>
+        future_type run(Executor exec) {
+            assert(remaining.load(std::memory_order_acquire) == 0 && "task_graph: already running");
+
+            auto roots = prepare();
+            done.construct();
+            auto res = done.ptr()->get_future();
+            failed.store(false, std::memory_order_relaxed);
+
+            if (works.empty()) {
+                finish();
+                return res;
+            }
+
+            remaining.store(works.size(), std::memory_order_release);
+            for (auto r : roots) {
+                dispatch(exec, r);
+            }
+            return res;
+        }
+    };
+}
+
+#endif
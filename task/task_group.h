@@ -0,0 +1,192 @@
+#ifndef LITE_FNDS_TASK_GROUP_H
+#define LITE_FNDS_TASK_GROUP_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../base/traits.h"
+#include "../memory/ref_ptr.h"
+#include "../memory/result_t.h"
+#include "../utility/ms_queue.h"
+#include "../utility/yield.h"
+#include "task_wrapper.h"
+
+/**
+ * Structured fork-join over any executor taking task_wrapper_sbo (exec->dispatch(task_wrapper_sbo&&)).
+ *
+ * task_group<executor*> g(&executor);
+ * g.run([] { ... });                            // void
+ * g.run(make_task(parse, std::move(chunk)));    // result_t<T, E>, an error is collected
+ * auto r = g.wait();                            // result_t<void, std::vector<E>>
+ *
+ * run() keeps the task in the group's own queue and dispatches a small pump to the executor which
+ * runs whatever group task is next. wait() pops the group tasks itself and runs them on the calling
+ * thread, so a waiter (also a nested one, inside an executor thread) helps rather than sleeps; it
+ * only yields once everything left is already running elsewhere. The pumps finding the queue empty
+ * return at once.
+ *
+ * cancel() drops the tasks which have not started yet, the running ones may poll cancelled().
+ * Every failure is kept: a result_t error, or an exception if E can be made from std::exception_ptr.
+ * The group waits in its destructor too, the errors nobody collected with wait() are dropped there.
+ */
+
+namespace lite_fnds {
+    namespace task_group_impl {
+        template <typename E>
+        struct core : ref_counted<core<E>> {
+            ms_queue<task_wrapper_sbo> pending;
+            ms_queue<E> errors;
+            // queued and running
+            std::atomic<size_t> outstanding { 0 };
+            std::atomic<bool> cancelled { false };
+
+            // one group task, if any is queued
+            bool run_one() noexcept {
+                {
+                    auto t = pending.try_pop();
+                    if (!t.has_value()) {
+                        return false;
+                    }
+
+                    LIKELY_IF(!cancelled.load(std::memory_order_acquire)) {
+                        t.get()();
+                    }
+                }
+                // the task and its captures are gone before a waiter may return
+                outstanding.fetch_sub(1, std::memory_order_acq_rel);
+                return true;
+            }
+
+            // helps until every group task is done
+            void join() noexcept {
+                while (outstanding.load(std::memory_order_acquire) != 0) {
+                    if (!run_one()) {
+                        yield();
+                    }
+                }
+            }
+
+            template <typename F>
+            void invoke(F& f) noexcept {
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+                try {
+#endif
+                    call(std::is_void<invoke_result_t<F&>> {}, f);
+#if LFNDS_COMPILER_HAS_EXCEPTIONS
+                } catch (...) {
+                    fail_current(std::is_constructible<E, std::exception_ptr> {});
+                }
+#endif
+            }
+
+            template <typename F>
+            void call(std::true_type /*void*/, F& f) {
+                f();
+            }
+
+            template <typename F>
+            void call(std::false_type, F& f) {
+                collect(f());
+            }
+
+            template <typename R, std::enable_if_t<is_result_t<R>::value>* = nullptr>
+            void collect(R&& r) noexcept {
+                static_assert(std::is_constructible<E, typename std::decay_t<R>::error_type&&>::value,
+                    "the error type of a group task must convert to the error type of the group");
+                if (r.has_error()) {
+                    errors.wait_and_emplace(E(std::move(r.error())));
+                }
+            }
+
+            template <typename R, std::enable_if_t<!is_result_t<R>::value>* = nullptr>
+            void collect(R&&) noexcept {
+            }
+
+            void fail_current(std::true_type) noexcept {
+                errors.wait_and_emplace(E(std::current_exception()));
+            }
+
+            void fail_current(std::false_type) noexcept {
+                std::terminate();
+            }
+        };
+    }
+
+    template <typename Executor, typename E = std::exception_ptr>
+    class task_group {
+        static_assert(std::is_nothrow_move_constructible<E>::value, "E must be nothrow move constructible");
+
+        using core_t = task_group_impl::core<E>;
+
+        Executor exec;
+        ref_ptr<core_t> core;
+
+    public:
+        using error_type = E;
+        using result_type = result_t<void, std::vector<E>>;
+
+        explicit task_group(Executor e)
+            : exec(std::move(e))
+            , core(new core_t()) {
+        }
+
+        task_group(const task_group&) = delete;
+        task_group& operator=(const task_group&) = delete;
+        task_group(task_group&&) = delete;
+        task_group& operator=(task_group&&) = delete;
+
+        // joins without collecting, the queued errors go with the core
+        ~task_group() noexcept {
+            core->join();
+        }
+
+        // f is invoked without arguments and may return void or a result_t
+        template <typename F>
+        void run(F&& f) {
+            core->outstanding.fetch_add(1, std::memory_order_relaxed);
+
+            core_t* c = core.get();
+            core->pending.wait_and_emplace(task_wrapper_sbo([c, f = std::decay_t<F>(std::forward<F>(f))]() mutable noexcept {
+                c->invoke(f);
+            }));
+
+            // the pump keeps the core alive, it may run long after wait() has drained the queue
+            exec->dispatch(task_wrapper_sbo([c = core]() noexcept {
+                c->run_one();
+            }));
+        }
+
+        // runs the queued group tasks on this thread until every task is done, then hands out
+        // the collected errors; the group is reusable afterwards.
+        result_type wait() {
+            core->join();
+
+            std::vector<E> errs;
+            for (auto e = core->errors.try_pop(); e.has_value(); e = core->errors.try_pop()) {
+                errs.emplace_back(std::move(e.get()));
+            }
+            core->cancelled.store(false, std::memory_order_relaxed);
+
+            if (errs.empty()) {
+                return result_type(value_tag);
+            }
+            return result_type(error_tag, std::move(errs));
+        }
+
+        // the tasks not started yet are dropped without running
+        void cancel() noexcept {
+            core->cancelled.store(true, std::memory_order_release);
+        }
+
+        bool cancelled() const noexcept {
+            return core->cancelled.load(std::memory_order_acquire);
+        }
+    };
+}
+
+#endif
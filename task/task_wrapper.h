@@ -12,8 +12,23 @@
 #include "../base/inplace_base.h"
 #include "../base/type_erase_base.h"
 
+// define LFNDS_TASK_NO_HEAP to 1 to reject, at compile time, every task which would not fit
+// into the buffer of its task_wrapper and so fall back to the heap.
+#ifndef LFNDS_TASK_NO_HEAP
+#define LFNDS_TASK_NO_HEAP 0
+#endif
+
 namespace lite_fnds {
     namespace task_handle_impl {
+        // shows up in the diagnostic together with the sizes involved.
+        template <size_t task_size, size_t task_align, size_t buffer_size, size_t buffer_align, bool stored_inline>
+        struct task_heap_fallback {
+            static_assert(stored_inline || !LFNDS_TASK_NO_HEAP,
+                "LFNDS_TASK_NO_HEAP: this task would be heap allocated, it is bigger than the buffer of the "
+                "task_wrapper (or not nothrow movable/copyable). Pick a bigger wrapper, e.g. task_wrapper_sbo2/4.");
+            static constexpr bool value = stored_inline;
+        };
+
         struct task_vtable : basic_vtable {
             void (*run)(void *) noexcept;
 
@@ -22,8 +37,9 @@ namespace lite_fnds {
                 fn_move_construct_t *fmove,
                 fn_safe_relocate_t* fsafe_reloc,
                 fn_destroy_t *fdestroy,
+                bool trivial_reloc,
                 void (*frun)(void *) noexcept) noexcept :
-                basic_vtable{fcopy, fmove, fsafe_reloc, fdestroy},
+                basic_vtable{fcopy, fmove, fsafe_reloc, fdestroy, trivial_reloc},
                 run(frun) {
             }
         };
@@ -34,23 +50,73 @@ namespace lite_fnds {
                 (*tr_ptr<T, sbo_enabled>(p))();
             }
 
-            static const task_vtable* table_for() noexcept {
-                static const task_vtable vt (
-                        fcopy_construct<T, sbo_enabled>(),
-                        fmove_construct<T, sbo_enabled>(),
-                        fsafe_relocate<T, sbo_enabled>(),
-                        fdestroy<T, sbo_enabled>(),
-                    &task_vfns::run
-                );
+            // constant initialized, no guard on emplace
+            static constexpr task_vtable vt {
+                fcopy_construct<T, sbo_enabled>(),
+                fmove_construct<T, sbo_enabled>(),
+                fsafe_relocate<T, sbo_enabled>(),
+                fdestroy<T, sbo_enabled>(),
+                ftrivially_relocatable<T, sbo_enabled>(),
+                &task_vfns::run
+            };
+
+            static constexpr const task_vtable* table_for() noexcept {
                 return &vt;
             }
         };
+
+        template <typename T, bool sbo_enabled>
+        constexpr task_vtable task_vfns<T, sbo_enabled>::vt;
+
+        using task_run_t = void(void *);
+
+        // where operator() finds run: behind the vtable, or kept next to the buffer
+        // (like callable_storage_t::invoker_) at the cost of one pointer of buffer.
+        template <bool inline_run>
+        struct task_run_slot {
+            FORCE_INLINE void run(const basic_vtable* vt, void* data) const noexcept {
+                static_cast<const task_vtable*>(vt)->run(data);
+            }
+
+            void fill(const task_vtable*) noexcept {
+            }
+
+            void assign(const task_run_slot&) noexcept {
+            }
+
+            void swap(task_run_slot&) noexcept {
+            }
+        };
+
+        template <>
+        struct task_run_slot<true> {
+            task_run_t* run_ = nullptr;
+
+            FORCE_INLINE void run(const basic_vtable*, void* data) const noexcept {
+                run_(data);
+            }
+
+            void fill(const task_vtable* vt) noexcept {
+                run_ = vt->run;
+            }
+
+            void assign(const task_run_slot& rhs) noexcept {
+                run_ = rhs.run_;
+            }
+
+            void swap(task_run_slot& rhs) noexcept {
+                using std::swap;
+                swap(run_, rhs.run_);
+            }
+        };
     }
 
     // this is not thread safe
-    template <size_t sbo_size_, size_t align_>
-    class task_wrapper : public raw_type_erase_base<task_wrapper<sbo_size_, align_>, sbo_size_, align_>  {
-        using base = raw_type_erase_base<task_wrapper<sbo_size_, align_>, sbo_size_, align_>;
+    template <size_t sbo_size_, size_t align_, bool inline_run_ = false>
+    class task_wrapper : public raw_type_erase_base<task_wrapper<sbo_size_, align_, inline_run_>, sbo_size_, align_>,
+                         private task_handle_impl::task_run_slot<inline_run_> {
+        using base = raw_type_erase_base<task_wrapper<sbo_size_, align_, inline_run_>, sbo_size_, align_>;
+        using run_slot = task_handle_impl::task_run_slot<inline_run_>;
 
         template <class F>
         struct is_compatible {
@@ -70,6 +136,7 @@ namespace lite_fnds {
     public:
         static constexpr size_t sbo_size = sbo_size_;
         static constexpr size_t align = align_;
+        static constexpr bool inline_run = inline_run_;
 
         template <typename T, bool sbo_enable>
         void fill_vtable() noexcept {
@@ -77,8 +144,12 @@ namespace lite_fnds {
                 "T must be a non-reference object type.");
             static_assert(is_compatible<T>::value, 
                 "the given type is not compatible with task_wrapper container. T must be void() noexcept.");
+            static_assert(task_handle_impl::task_heap_fallback<sizeof(T), alignof(T), sbo_size, align, sbo_enable>::value
+                || !LFNDS_TASK_NO_HEAP, "task_wrapper: heap fallback");
 
-            this->_vtable = task_handle_impl::task_vfns<T, sbo_enable>::table_for();
+            auto vt = task_handle_impl::task_vfns<T, sbo_enable>::table_for();
+            this->_vtable = vt;
+            run_slot::fill(vt);
         }
 
         task_wrapper() noexcept = default;
@@ -96,19 +167,24 @@ namespace lite_fnds {
         }
 
         using base::emplace;
-        using base::swap;
         using base::clear;
 
+        void swap(task_wrapper& rhs) noexcept {
+            base::swap(rhs);
+            run_slot::swap(rhs);
+        }
+
         bool empty() const noexcept {
             return !this->has_value();
         }
 
         task_wrapper(task_wrapper&& rhs) noexcept : base() {
             if (rhs._vtable) {
-                // use safe_relocate: always noexcept
-                rhs._vtable->safe_relocate(this->_data, rhs._data);
+                // a memcpy for trivially relocatable payloads, safe_relocate (always noexcept) otherwise
+                base::relocate(rhs._vtable, this->_data, rhs._data);
 
                 this->_vtable = rhs._vtable;
+                run_slot::assign(rhs);
                 rhs._vtable = nullptr;
             } else {
                 this->_vtable = nullptr;
@@ -120,8 +196,9 @@ namespace lite_fnds {
                 // clear current
                 this->clear();
                 if (rhs._vtable) {
-                    rhs._vtable->safe_relocate(this->_data, rhs._data);
+                    base::relocate(rhs._vtable, this->_data, rhs._data);
                     this->_vtable = rhs._vtable;
+                    run_slot::assign(rhs);
                     rhs._vtable = nullptr;
                 } else {
                     this->_vtable = nullptr;
@@ -133,18 +210,41 @@ namespace lite_fnds {
 
         void operator()() noexcept {
             assert(this->_vtable);
-            static_cast<const task_handle_impl::task_vtable*>(this->_vtable)->run(this->_data);
+            run_slot::run(this->_vtable, this->_data);
         }
     };
 
-    template <size_t _sbo_size, size_t align>
-    void swap(task_wrapper<_sbo_size, align>& a, task_wrapper<_sbo_size, align>& b) noexcept {
+    template <size_t _sbo_size, size_t align, bool inline_run>
+    void swap(task_wrapper<_sbo_size, align, inline_run>& a, task_wrapper<_sbo_size, align, inline_run>& b) noexcept {
         a.swap(b);
     }
 
-    using task_wrapper_sbo = task_wrapper<CACHE_LINE_SIZE - sizeof(std::nullptr_t), alignof(std::max_align_t)>;
+    // a task_wrapper spanning exactly lines cache lines, the vtable pointer included.
+    template <size_t lines>
+    using task_wrapper_lines = task_wrapper<lines * CACHE_LINE_SIZE - sizeof(std::nullptr_t), alignof(std::max_align_t)>;
+
+    using task_wrapper_sbo = task_wrapper_lines<1>;
     static_assert(sizeof(task_wrapper_sbo) == CACHE_LINE_SIZE,
                   "task_wrapper_sbo must fit exactly in one cache line.");
+
+    using task_wrapper_sbo2 = task_wrapper_lines<2>;
+    static_assert(sizeof(task_wrapper_sbo2) == 2 * CACHE_LINE_SIZE,
+                  "task_wrapper_sbo2 must fit exactly in two cache lines.");
+
+    using task_wrapper_sbo4 = task_wrapper_lines<4>;
+    static_assert(sizeof(task_wrapper_sbo4) == 4 * CACHE_LINE_SIZE,
+                  "task_wrapper_sbo4 must fit exactly in four cache lines.");
+
+    // true if F is stored in the buffer of Wrapper, i.e. wrapping it never allocates.
+    template <typename Wrapper, typename F, typename T = std::decay_t<F>>
+    constexpr bool task_fits_v = sizeof(T) <= Wrapper::sbo_size
+        && alignof(T) <= Wrapper::align
+        && can_strong_move_or_copy_constructible<T>::value;
+
+    // invoking it is a single indirect call, the buffer gives up one pointer for that.
+    using task_wrapper_inline = task_wrapper<CACHE_LINE_SIZE - 2 * sizeof(std::nullptr_t), alignof(std::max_align_t), true>;
+    static_assert(sizeof(task_wrapper_inline) == CACHE_LINE_SIZE,
+                  "task_wrapper_inline must fit exactly in one cache line.");
 }
 
 #endif //__TASK_WRAPPER_H__
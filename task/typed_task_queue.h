@@ -0,0 +1,164 @@
+#ifndef LITE_FNDS_TYPED_TASK_QUEUE_H
+#define LITE_FNDS_TYPED_TASK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "../base/inplace_base.h"
+#include "../base/traits.h"
+#include "../utility/yield.h"
+#include "task_wrapper.h"
+
+/**
+ * typed_task_queue<Task, Executor>: a batch stage for many tasks of one type, e.g. the task<F, Args...>
+ * of make_task, in front of any executor taking task_wrapper_sbo (exec->dispatch(task_wrapper_sbo&&)).
+ *
+ * typed_task_queue<decltype(make_task(work, 0)), executor*> q(&executor);
+ * for (int i = 0; i < n; ++i)
+ *     q.push(make_task(work, int(i)));    // kept by value, no type erasure
+ *
+ * The tasks sit back to back in one ring (the ready flags live in an array of their own), a drain
+ * runs them in order through a direct call of Task::operator(), which the compiler can inline.
+ * Only the drain goes through the executor: one task_wrapper_sbo per batch of up to max_batch
+ * tasks instead of one per task. A producer registers a drain only if none is pending.
+ *
+ * Any number of producers, at most one drain runs at a time. The results of the tasks are dropped.
+ * The destructor waits until no drain is pending or running, the executor has to keep running until
+ * then; no producer may push concurrently with it.
+ */
+
+namespace lite_fnds {
+    template <typename Task, typename Executor, size_t capacity = 1024, size_t max_batch = capacity>
+    class typed_task_queue {
+        static_assert(conjunction_v<std::is_nothrow_move_constructible<Task>, std::is_nothrow_destructible<Task>>,
+            "Task should be nothrow move constructible and nothrow destructible.");
+        static_assert((capacity & (capacity - 1)) == 0, "capacity must be power of 2");
+        static_assert(max_batch > 0, "a drain has to run at least one task");
+
+        static constexpr size_t MASK = capacity - 1;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> _t { 0 };
+        pad_t<sizeof(_t)> _pad1;
+
+        // written by the drain only, read by the producers to tell a free slot
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> _h { 0 };
+        std::atomic<bool> _scheduled { false };
+        // drains dispatched and not returned yet, the last thing a drain touches
+        std::atomic<size_t> _drains { 0 };
+        pad_t<sizeof(_h) + sizeof(_scheduled) + sizeof(_drains)> _pad2;
+
+        Executor exec;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> _ready[capacity] {};
+        alignas(CACHE_LINE_SIZE) raw_inplace_storage_base<Task> _tasks[capacity];
+
+        void schedule() noexcept {
+            _drains.fetch_add(1, std::memory_order_relaxed);
+            exec->dispatch(task_wrapper_sbo([this]() noexcept {
+                drain();
+                _drains.fetch_sub(1, std::memory_order_release);
+            }));
+        }
+
+        // one attempt at a free slot, t is the claimed one
+        bool try_claim(size_t& t) noexcept {
+            t = _t.load(std::memory_order_relaxed);
+            return t - _h.load(std::memory_order_acquire) < capacity
+                && _t.compare_exchange_weak(t, t + 1, std::memory_order_relaxed, std::memory_order_relaxed);
+        }
+
+        // the producer side of the hand-off: the task is published before _scheduled is read,
+        // the drain clears _scheduled before it reads the next flag, seq_cst keeps one of them seeing the other.
+        void publish(size_t t) noexcept {
+            _ready[t & MASK].store(1, std::memory_order_seq_cst);
+            if (!_scheduled.load(std::memory_order_seq_cst) && !_scheduled.exchange(true, std::memory_order_acq_rel)) {
+                schedule();
+            }
+        }
+
+        void drain() noexcept {
+            for (;;) {
+                size_t h = _h.load(std::memory_order_relaxed);
+                size_t n = 0;
+                for (; n < max_batch; ++n, ++h) {
+                    const size_t i = h & MASK;
+                    if (!_ready[i].load(std::memory_order_acquire)) {
+                        break;
+                    }
+
+                    Task& task = *_tasks[i].ptr();
+                    task();
+                    _tasks[i].destroy();
+                    _ready[i].store(0, std::memory_order_relaxed);
+                    _h.store(h + 1, std::memory_order_release);
+                }
+
+                // more than a batch queued, give the executor's other work a turn
+                if (n == max_batch) {
+                    schedule();
+                    return;
+                }
+
+                _scheduled.store(false, std::memory_order_seq_cst);
+                if (!_ready[h & MASK].load(std::memory_order_seq_cst)
+                    || _scheduled.exchange(true, std::memory_order_acq_rel)) {
+                    return;
+                }
+            }
+        }
+
+    public:
+        using task_type = Task;
+
+        explicit typed_task_queue(Executor e) noexcept(std::is_nothrow_move_constructible<Executor>::value)
+            : exec(std::move(e)) {
+        }
+
+        typed_task_queue(const typed_task_queue&) = delete;
+        typed_task_queue& operator=(const typed_task_queue&) = delete;
+
+        // a drain still reads the ring after it cleared _scheduled, so _drains is what tells it gone
+        ~typed_task_queue() noexcept {
+            while (_drains.load(std::memory_order_acquire) != 0) {
+                yield();
+            }
+        }
+
+        // a claimed slot has to be filled, so a Task is only built in place if that can't throw
+        // false if the ring is full
+        template <typename... Args, std::enable_if_t<std::is_nothrow_constructible<Task, Args&&...>::value>* = nullptr>
+        bool try_push(Args&&... args) noexcept {
+            constexpr int max_retry = 8;
+
+            size_t t;
+            for (int attempt = 0; attempt < max_retry; ++attempt) {
+                if (try_claim(t)) {
+                    _tasks[t & MASK].construct(std::forward<Args>(args)...);
+                    publish(t);
+                    return true;
+                }
+
+                yield();
+            }
+            return false;
+        }
+
+        // waits while the ring is full
+        template <typename... Args, std::enable_if_t<std::is_nothrow_constructible<Task, Args&&...>::value>* = nullptr>
+        void push(Args&&... args) noexcept {
+            size_t t;
+            for (;; yield()) {
+                if (try_claim(t)) {
+                    _tasks[t & MASK].construct(std::forward<Args>(args)...);
+                    publish(t);
+                    return;
+                }
+            }
+        }
+    };
+}
+
+#endif
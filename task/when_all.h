@@ -0,0 +1,212 @@
+#ifndef LITE_FNDS_WHEN_ALL_H
+#define LITE_FNDS_WHEN_ALL_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../base/traits.h"
+#include "lite_future.h"
+
+/**
+ * Fan-in over lite_futures, without a thread blocked per join.
+ *
+ * auto all = when_all(std::move(f1), std::move(f2));    // lite_future<std::tuple<result_t<A, E1>, result_t<B, E2>>>
+ * auto vec = when_all(fs.begin(), fs.end());            // lite_future<std::vector<result_t<T, E>>>
+ * auto any = when_any(fs.begin(), fs.end());            // lite_future<when_any_result<T, E>>
+ *
+ * The inputs are consumed. Each one gets a continuation which only decrements one atomic counter
+ * in a join block, allocated once up front together with the room for the results; the last
+ * finisher moves the results out of the input states and completes the returned future without
+ * allocating. Building the join may throw (std::bad_alloc), completing it can't. when_any
+ * completes with the first finisher, the others are dropped as they arrive. Neither ever completes
+ * with an error, the individual result_t carry those.
+ */
+
+namespace lite_fnds {
+    template <typename T>
+    struct is_lite_future : std::false_type {};
+
+    template <typename T, typename E>
+    struct is_lite_future<lite_future<T, E>> : std::true_type {};
+
+    template <typename T, typename E>
+    struct when_any_result {
+        size_t index;
+        result_t<T, E> result;
+    };
+
+    namespace lite_future_impl {
+        template <typename... States>
+        struct all_join : ref_counted<all_join<States...>, atomic_ref_count, state_delete> {
+            using value_type = std::tuple<typename States::result_type...>;
+
+            std::atomic<size_t> remaining { sizeof...(States) };
+            std::tuple<ref_ptr<States>...> inputs;
+            lite_promise<value_type> promise;
+
+            explicit all_join(ref_ptr<States>... s)
+                : inputs(std::move(s)...) {
+            }
+
+            void arrive() noexcept {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    finish(std::index_sequence_for<States...> {});
+                }
+            }
+
+            template <size_t... I>
+            void finish(std::index_sequence<I...>) noexcept {
+                promise.set_value(value_type(std::move(std::get<I>(inputs)->result())...));
+            }
+
+            // every continuation holds the join, the join holds every input until the last one arrives
+            template <size_t... I>
+            static void subscribe(const ref_ptr<all_join>& j, std::index_sequence<I...>) noexcept {
+                (void)std::initializer_list<int> { (std::get<I>(j->inputs)->on_ready(task_wrapper_sbo([j]() noexcept {
+                    j->arrive();
+                })), 0)... };
+            }
+        };
+
+        template <typename State>
+        struct range_all_join : ref_counted<range_all_join<State>, atomic_ref_count, state_delete> {
+            using value_type = std::vector<typename State::result_type>;
+
+            std::atomic<size_t> remaining;
+            std::vector<ref_ptr<State>> inputs;
+            // reserved here, so the last finisher only moves the results in
+            value_type results;
+            lite_promise<value_type> promise;
+
+            explicit range_all_join(std::vector<ref_ptr<State>>&& s)
+                : remaining { s.size() }
+                , inputs(std::move(s)) {
+                results.reserve(inputs.size());
+            }
+
+            void arrive() noexcept {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    for (auto& s : inputs) {
+                        results.emplace_back(std::move(s->result()));
+                    }
+                    promise.set_value(std::move(results));
+                }
+            }
+        };
+
+        template <typename State>
+        struct any_join : ref_counted<any_join<State>, atomic_ref_count, state_delete> {
+            using value_type = when_any_result<typename State::result_type::value_type,
+                typename State::result_type::error_type>;
+
+            std::atomic<bool> done { false };
+            std::vector<ref_ptr<State>> inputs;
+            lite_promise<value_type> promise;
+
+            explicit any_join(std::vector<ref_ptr<State>>&& s)
+                : inputs(std::move(s)) {
+            }
+
+            void arrive(size_t i) noexcept {
+                if (!done.exchange(true, std::memory_order_acq_rel)) {
+                    promise.set_value(value_type { i, std::move(inputs[i]->result()) });
+                }
+            }
+        };
+
+        template <typename It>
+        using future_of_t = std::decay_t<typename std::iterator_traits<It>::reference>;
+
+        template <typename It>
+        using state_of_t = shared_state<typename future_of_t<It>::value_type, typename future_of_t<It>::error_type>;
+
+        template <typename States, typename It>
+        void reserve_for(States& states, It first, It last, std::forward_iterator_tag) {
+            states.reserve(static_cast<size_t>(std::distance(first, last)));
+        }
+
+        // a single pass range can't be measured up front
+        template <typename States, typename It>
+        void reserve_for(States&, It, It, std::input_iterator_tag) noexcept {
+        }
+
+        template <typename It>
+        std::vector<ref_ptr<state_of_t<It>>> take_states(It first, It last) {
+            std::vector<ref_ptr<state_of_t<It>>> states;
+            reserve_for(states, first, last, typename std::iterator_traits<It>::iterator_category {});
+            for (; first != last; ++first) {
+                states.emplace_back(future_access::take_state(*first));
+            }
+            return states;
+        }
+    }
+
+    inline lite_future<std::tuple<>> when_all() {
+        lite_promise<std::tuple<>> p;
+        auto res = p.get_future();
+        p.set_value(std::tuple<>());
+        return res;
+    }
+
+    template <typename... Ts, typename... Es>
+    auto when_all(lite_future<Ts, Es>... fs) {
+        using join_t = lite_future_impl::all_join<lite_future_impl::shared_state<Ts, Es>...>;
+
+        auto j = lite_future_impl::make_block<join_t>(lite_future_impl::future_access::take_state(fs)...);
+        auto res = j->promise.get_future();
+        join_t::subscribe(j, std::index_sequence_for<Ts...> {});
+        return res;
+    }
+
+    template <typename It, std::enable_if_t<is_lite_future<lite_future_impl::future_of_t<It>>::value>* = nullptr>
+    auto when_all(It first, It last) {
+        using join_t = lite_future_impl::range_all_join<lite_future_impl::state_of_t<It>>;
+
+        auto j = lite_future_impl::make_block<join_t>(lite_future_impl::take_states(first, last));
+        auto res = j->promise.get_future();
+        if (j->inputs.empty()) {
+            j->promise.set_value(typename join_t::value_type());
+            return res;
+        }
+
+        for (auto& s : j->inputs) {
+            s->on_ready(task_wrapper_sbo([j]() noexcept {
+                j->arrive();
+            }));
+        }
+        return res;
+    }
+
+    template <typename It, std::enable_if_t<is_lite_future<lite_future_impl::future_of_t<It>>::value>* = nullptr>
+    auto when_any(It first, It last) {
+        using join_t = lite_future_impl::any_join<lite_future_impl::state_of_t<It>>;
+
+        auto j = lite_future_impl::make_block<join_t>(lite_future_impl::take_states(first, last));
+        assert(!j->inputs.empty() && "when_any needs at least one future");
+        auto res = j->promise.get_future();
+
+        // the losers keep the join (and their own states) alive until they arrive as well
+        for (size_t i = 0; i < j->inputs.size(); ++i) {
+            j->inputs[i]->on_ready(task_wrapper_sbo([j, i]() noexcept {
+                j->arrive(i);
+            }));
+        }
+        return res;
+    }
+
+    template <typename T, typename E, typename... Fs,
+        std::enable_if_t<conjunction_v<std::is_same<Fs, lite_future<T, E>>...>>* = nullptr>
+    auto when_any(lite_future<T, E> f, Fs... fs) {
+        lite_future<T, E> all[] = { std::move(f), std::move(fs)... };
+        return when_any(std::begin(all), std::end(all));
+    }
+}
+
+#endif
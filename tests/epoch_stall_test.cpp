@@ -0,0 +1,74 @@
+// Stalled readers must not make ebr_mgr leak.
+//
+// g++ -std=c++14 -O2 -pthread -I.. epoch_stall_test.cpp ../memory/epoch.cpp -o epoch_stall_test
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../memory/epoch.h"
+
+using lite_fnds::ebr_mgr;
+using lite_fnds::epoch_guard;
+
+namespace {
+    std::atomic<size_t> freed { 0 };
+
+    struct node {
+        size_t payload[4];
+
+        ~node() {
+            freed.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    bool run(size_t readers, size_t retires) {
+        freed.store(0);
+        const size_t leaked_before = ebr_mgr::leaked_count();
+
+        std::atomic<bool> stop { false };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < readers; ++i) {
+            threads.emplace_back([&stop, i] {
+                for (size_t n = 0; !stop.load(std::memory_order_relaxed); ++n) {
+                    epoch_guard guard;
+                    // a reader preempted inside its guard, every reader now and then
+                    if (n % 1024 == i) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    }
+                }
+            });
+        }
+
+        for (size_t i = 0; i < retires; ++i) {
+            ebr_mgr::retire(new node());
+        }
+
+        stop.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (int i = 0; i < 4; ++i) {
+            ebr_mgr::sweep_and_reclaim();
+        }
+
+        const size_t leaked = ebr_mgr::leaked_count() - leaked_before;
+        const size_t done = freed.load();
+        std::printf("readers %zu: retired %zu, freed %zu, leaked %zu\n", readers, retires, done, leaked);
+        return leaked == 0 && done == retires;
+    }
+}
+
+int main() {
+    constexpr size_t retires = 200000;
+
+    bool ok = true;
+    for (size_t readers : { 0, 1, 2, 4 }) {
+        ok = run(readers, retires) && ok;
+    }
+
+    std::printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// ms_queue under many producers and consumers: nothing lost, nothing duplicated, and the items of one
+// producer leave in the order they went in.
+//
+// g++ -std=c++14 -O2 -pthread -I.. ms_queue_stress_test.cpp ../memory/hazard_ptr.cpp -o ms_queue_stress_test
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../utility/ms_queue.h"
+
+using lite_fnds::ms_queue;
+
+namespace {
+    // producer id in the high half, its sequence number in the low half
+    uint64_t encode(uint64_t producer, uint64_t seq) noexcept {
+        return (producer << 32) | seq;
+    }
+
+    struct tracked {
+        static std::atomic<long> live;
+
+        uint64_t value;
+
+        explicit tracked(uint64_t v) noexcept
+            : value(v) {
+            live.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        tracked(tracked&& rhs) noexcept
+            : value(rhs.value) {
+            live.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ~tracked() {
+            live.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<long> tracked::live { 0 };
+
+    bool run(size_t producers, size_t consumers, size_t per_producer) {
+        ms_queue<uint64_t> q;
+        const size_t total = producers * per_producer;
+
+        std::atomic<size_t> popped { 0 };
+        std::atomic<uint64_t> checksum { 0 };
+        std::atomic<bool> ordered { true };
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&q, p, per_producer] {
+                for (size_t i = 0; i < per_producer; ++i) {
+                    q.wait_and_emplace(encode(p, i));
+                }
+            });
+        }
+
+        for (size_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&, producers] {
+                // the last sequence number this consumer saw from every producer
+                std::vector<int64_t> last(producers, -1);
+                uint64_t sum = 0;
+                while (popped.load(std::memory_order_relaxed) < total) {
+                    auto v = q.try_pop();
+                    if (!v.has_value()) {
+                        continue;
+                    }
+                    popped.fetch_add(1, std::memory_order_relaxed);
+
+                    const uint64_t x = v.get();
+                    const auto p = static_cast<size_t>(x >> 32);
+                    const auto seq = static_cast<int64_t>(x & 0xffffffffu);
+                    if (p >= producers || seq <= last[p]) {
+                        ordered.store(false);
+                    }
+                    last[p] = seq;
+                    sum += x;
+                }
+                checksum.fetch_add(sum);
+            });
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        uint64_t expected = 0;
+        for (size_t p = 0; p < producers; ++p) {
+            for (size_t i = 0; i < per_producer; ++i) {
+                expected += encode(p, i);
+            }
+        }
+
+        const bool ok = popped.load() == total && checksum.load() == expected && ordered.load() && q.empty();
+        std::printf("%zuP/%zuC x %zu: popped %zu, checksum %s, order %s\n", producers, consumers, per_producer,
+            popped.load(), checksum.load() == expected ? "ok" : "BAD", ordered.load() ? "ok" : "BAD");
+        return ok;
+    }
+
+    // the values still queued when the queue goes away are destroyed with it
+    bool leftovers() {
+        {
+            ms_queue<tracked> q;
+            for (uint64_t i = 0; i < 1000; ++i) {
+                q.wait_and_emplace(tracked(i));
+            }
+            for (int i = 0; i < 500; ++i) {
+                (void)q.try_pop();
+            }
+        }
+        const bool ok = tracked::live.load() == 0;
+        std::printf("leftovers destroyed: %s\n", ok ? "ok" : "BAD");
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = true;
+    ok = run(1, 1, 200000) && ok;
+    ok = run(4, 4, 200000) && ok;
+    ok = run(8, 2, 50000) && ok;
+    ok = run(2, 8, 200000) && ok;
+    ok = leftovers() && ok;
+
+    lite_fnds::hp_mgr::sweep_and_reclaim();
+    std::printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+// reclaim drivers: with one attached, the retiring threads hand their buffers over and the sweeps run
+// on the driver side; on_idle() reclaims what is pending, and nothing is lost or leaked on the way.
+//
+// g++ -std=c++14 -O2 -pthread -I.. reclaim_driver_test.cpp ../memory/hazard_ptr.cpp -o reclaim_driver_test
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../memory/reclaim_driver.h"
+
+using namespace lite_fnds;
+
+namespace {
+    std::atomic<long> live { 0 };
+    std::atomic<long> freed_by_retirers { 0 };
+    thread_local bool retiring_thread = false;
+
+    struct object {
+        size_t value;
+
+        explicit object(size_t v) noexcept
+            : value(v) {
+            live.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    struct destroy {
+        void operator()(object* p) const noexcept {
+            if (retiring_thread) {
+                freed_by_retirers.fetch_add(1, std::memory_order_relaxed);
+            }
+            live.fetch_sub(1, std::memory_order_relaxed);
+            delete p;
+        }
+    };
+
+    // one worker thread, held by the driver through a shared_ptr
+    class worker_executor {
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::deque<task_wrapper_sbo> tasks_;
+        bool stop_ = false;
+        std::thread worker_;
+
+    public:
+        std::atomic<size_t> ran { 0 };
+
+        worker_executor()
+            : worker_ { [this] {
+                std::unique_lock<std::mutex> lk(mtx_);
+                for (;;) {
+                    cv_.wait(lk, [this] { return stop_ || !tasks_.empty(); });
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    auto t = std::move(tasks_.front());
+                    tasks_.pop_front();
+                    lk.unlock();
+                    t();
+                    ran.fetch_add(1, std::memory_order_relaxed);
+                    lk.lock();
+                }
+            } } {
+        }
+
+        ~worker_executor() {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            worker_.join();
+        }
+
+        void dispatch(task_wrapper_sbo&& t) noexcept {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                tasks_.emplace_back(std::move(t));
+            }
+            cv_.notify_one();
+        }
+    };
+
+    // readers keep protecting the current object while the writers replace and retire it
+    void churn(size_t writers, size_t per_writer) {
+        std::atomic<object*> shared { new object(0) };
+        std::atomic<bool> stop { false };
+
+        std::thread reader([&] {
+            hazard_ptr hp;
+            size_t acc = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                acc += hp.acquire_protected(shared)->value;
+                hp.unprotect();
+            }
+            (void)acc;
+        });
+
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < writers; ++w) {
+            threads.emplace_back([&, w] {
+                retiring_thread = true;
+                for (size_t i = 0; i < per_writer; ++i) {
+                    hp_mgr::retire(shared.exchange(new object(w * per_writer + i)), destroy {});
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        stop.store(true);
+        reader.join();
+        hp_mgr::retire(shared.exchange(nullptr), destroy {});
+    }
+
+    // one thread retires less than the shared list takes, with a driver attached it frees none of it
+    // itself; returns what it did free before it exits (and hands its buffer over).
+    long hand_over() {
+        long freed = -1;
+        std::thread([&freed] {
+            retiring_thread = true;
+            freed_by_retirers.store(0);
+            for (size_t i = 0; i < hp_mgr::retire_list_capacity - hp_mgr::retire_threshold; ++i) {
+                hp_mgr::retire(new object(i), destroy {});
+            }
+            freed = freed_by_retirers.load();
+        }).join();
+        return freed;
+    }
+
+    template <typename Done>
+    bool eventually(Done done) {
+        for (int i = 0; i < 5000 && !done(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return done();
+    }
+
+    bool check(const char* name, bool ok) {
+        std::printf("%-52s %s\n", name, ok ? "ok" : "BAD");
+        return ok;
+    }
+
+    bool executor_driver() {
+        bool ok = true;
+        auto exec = std::make_shared<worker_executor>();
+        {
+            executor_reclaim_driver<std::shared_ptr<worker_executor>> drv(exec);
+
+            ok = check("executor driver: the retiring thread frees nothing", hand_over() == 0) && ok;
+            ok = check("executor driver: a sweep ran as an executor task",
+                eventually([&] { return exec->ran.load() > 0; })) && ok;
+
+            churn(4, 100000);
+            drv.on_idle();
+            ok = check("executor driver: on_idle leaves nothing pending", hp_mgr::pending_count() == 0) && ok;
+        }
+        // the driver is gone, the executor it held still runs the sweeps it had dispatched
+        exec.reset();
+        hp_mgr::sweep_and_reclaim();
+        ok = check("executor driver: everything freed", live.load() == 0) && ok;
+        return ok;
+    }
+
+    bool thread_driver() {
+        bool ok = true;
+        {
+            reclaim_thread<> drv(std::chrono::milliseconds(5));
+
+            ok = check("reclaim thread: the retiring thread frees nothing", hand_over() == 0) && ok;
+            ok = check("reclaim thread: its sweeps empty the shared list",
+                eventually([] { return hp_mgr::pending_count() == 0; })) && ok;
+
+            churn(4, 100000);
+        }
+        hp_mgr::sweep_and_reclaim();
+        ok = check("reclaim thread: everything freed", live.load() == 0) && ok;
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = true;
+    ok = executor_driver() && ok;
+    ok = thread_driver() && ok;
+    ok = check("nothing leaked", hp_mgr::leaked_count() == 0) && ok;
+
+    std::printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -89,7 +89,7 @@ namespace lite_fnds {
                 if (!rhs._vtable) {
                     this->_vtable = nullptr;
                 } else {
-                    rhs._vtable->safe_relocate(this->_data, rhs._data);
+                    base::relocate(rhs._vtable, this->_data, rhs._data);
                     this->_vtable = rhs._vtable;
                     invoker_ = rhs.invoker_;
                     rhs._vtable = nullptr;
@@ -104,7 +104,7 @@ namespace lite_fnds {
                 // clear current
                 this->clear();
                 if (rhs._vtable) {
-                    rhs._vtable->safe_relocate(this->_data, rhs._data);
+                    base::relocate(rhs._vtable, this->_data, rhs._data);
                     this->_vtable = rhs._vtable;
                     invoker_ = rhs.invoker_;
                     rhs._vtable = nullptr;
@@ -149,13 +149,15 @@ namespace lite_fnds {
                 return (*tr_ptr<T, sbo_enabled>(p))(std::forward<Args>(args)...);
             }
 
-            static const basic_vtable* table_for() noexcept {
-                static const basic_vtable vt{
-                        fcopy_construct<T, sbo_enabled>(),
-                        fmove_construct<T, sbo_enabled>(),
-                        fsafe_relocate<T, sbo_enabled>(),
-                        fdestroy<T, sbo_enabled>()
-                };
+            static constexpr basic_vtable vt{
+                fcopy_construct<T, sbo_enabled>(),
+                fmove_construct<T, sbo_enabled>(),
+                fsafe_relocate<T, sbo_enabled>(),
+                fdestroy<T, sbo_enabled>(),
+                ftrivially_relocatable<T, sbo_enabled>()
+            };
+
+            static constexpr const basic_vtable* table_for() noexcept {
                 return &vt;
             }
         };
@@ -280,6 +282,10 @@ namespace lite_fnds {
 #endif
     };
 
+    template <typename R, typename ... Args>
+    template <typename T, bool sbo_enabled>
+    constexpr basic_vtable callable_wrapper<R(Args...)>::callable_vfns<T, sbo_enabled>::vt;
+
     template <typename R, typename ... Args>
     class callable_wrapper <R(Args...) const> {
         template <typename T, bool sbo_enabled>
@@ -288,13 +294,15 @@ namespace lite_fnds {
                 return (*tr_ptr<T, sbo_enabled>(p))(std::forward<Args>(args)...);
             }
 
-            static const basic_vtable* table_for() noexcept {
-                static const basic_vtable vt{
-                        fcopy_construct<T, sbo_enabled>(),
-                        fmove_construct<T, sbo_enabled>(),
-                        fsafe_relocate<T, sbo_enabled>(),
-                        fdestroy<T, sbo_enabled>()
-                };
+            static constexpr basic_vtable vt{
+                fcopy_construct<T, sbo_enabled>(),
+                fmove_construct<T, sbo_enabled>(),
+                fsafe_relocate<T, sbo_enabled>(),
+                fdestroy<T, sbo_enabled>(),
+                ftrivially_relocatable<T, sbo_enabled>()
+            };
+
+            static constexpr const basic_vtable* table_for() noexcept {
                 return &vt;
             }
         };
@@ -418,6 +426,10 @@ namespace lite_fnds {
 #endif
     };
 
+    template <typename R, typename ... Args>
+    template <typename T, bool sbo_enabled>
+    constexpr basic_vtable callable_wrapper<R(Args...) const>::callable_vfns<T, sbo_enabled>::vt;
+
     template <typename callable>
     void swap(callable_wrapper<callable>& a, callable_wrapper<callable>& b) noexcept {
         a.swap(b);
@@ -0,0 +1,474 @@
+#ifndef LITE_FNDS_CONCURRENT_HASH_MAP_H
+#define LITE_FNDS_CONCURRENT_HASH_MAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../base/traits.h"
+#include "../memory/hazard_ptr.h"
+#include "../memory/inplace_t.h"
+
+/**
+ * Lock-free hash map (split-ordered list, Shalev & Shavit).
+ *
+ * All entries live in one sorted lock-free linked list (Michael), ordered by the bit reversed hash.
+ * A bucket is just a shortcut into that list through a dummy node, so doubling the bucket count never
+ * moves an entry: the new buckets get their dummies lazily, the first time they are used.
+ * The bucket directory is made of segments of growing size which are never reallocated.
+ *
+ * Lookups take no locks, they hold up to three hazards (prev / cur / next) of Domain while walking.
+ * Erased entries are retired through Domain. Key and value live inline in the list node.
+ * Values are immutable once inserted: find copies the value out, visit reads it in place.
+ */
+
+namespace lite_fnds {
+namespace chm_impl {
+    inline uint64_t reverse_bits(uint64_t v) noexcept {
+        v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+        v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+        v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+        v = ((v >> 8) & 0x00FF00FF00FF00FFull) | ((v & 0x00FF00FF00FF00FFull) << 8);
+        v = ((v >> 16) & 0x0000FFFF0000FFFFull) | ((v & 0x0000FFFF0000FFFFull) << 16);
+        return (v >> 32) | (v << 32);
+    }
+
+    // regular keys are odd, dummy keys even, so a bucket's dummy sorts before all of its entries.
+    inline uint64_t regular_key(uint64_t hash) noexcept {
+        return reverse_bits(hash | (1ull << 63));
+    }
+
+    inline uint64_t dummy_key(uint64_t bucket) noexcept {
+        return reverse_bits(bucket);
+    }
+}
+
+template <typename K, typename V,
+    typename Hash = std::hash<K>,
+    typename KeyEqual = std::equal_to<K>,
+    typename Domain = hp_mgr>
+class concurrent_hash_map {
+    static_assert(std::is_nothrow_destructible<K>::value && std::is_nothrow_destructible<V>::value,
+        "K and V must be nothrow destructible.");
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+private:
+    // the low bit of next marks the node as logically erased
+    struct node {
+        std::atomic<uintptr_t> next;
+        uint64_t so_key;
+        raw_inplace_storage_base<value_type> kv;
+
+        explicit node(uint64_t key) noexcept
+            : next { 0 }
+            , so_key { key } {
+        }
+
+        template <typename KK, typename... Args>
+        node(uint64_t key, KK&& k, Args&&... args)
+            : next { 0 }
+            , so_key { key } {
+            kv.construct(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<KK>(k)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        bool is_dummy() const noexcept {
+            return !(so_key & 1);
+        }
+
+        const K& key() const noexcept {
+            return kv.ptr()->first;
+        }
+
+        const V& value() const noexcept {
+            return kv.ptr()->second;
+        }
+    };
+
+    static constexpr uintptr_t mark_bit = 1;
+
+    static node* ptr_of(uintptr_t v) noexcept {
+        return reinterpret_cast<node*>(v & ~mark_bit);
+    }
+
+    static bool is_marked(uintptr_t v) noexcept {
+        return (v & mark_bit) != 0;
+    }
+
+    static uintptr_t raw_of(node* n) noexcept {
+        return reinterpret_cast<uintptr_t>(n);
+    }
+
+    static void delete_node(node* n) noexcept {
+        if (!n->is_dummy()) {
+            n->kv.destroy();
+        }
+        delete n;
+    }
+
+    static void retire(node* n) noexcept {
+        Domain::retire(n, [](node* p) noexcept {
+            delete_node(p);
+        });
+    }
+
+    // average entries per bucket before the bucket count doubles
+    static constexpr size_t max_load = 2;
+    // segment 0 holds bucket 0, segment s > 0 holds buckets [2^(s-1), 2^s)
+    static constexpr size_t max_segments = 64;
+
+    using bucket_t = std::atomic<node*>;
+    using hazards_t = basic_hazard_array<Domain, 3>;
+    // hazard cells of a walk
+    static constexpr size_t hp_next = 0, hp_cur = 1, hp_prev = 2;
+
+    std::atomic<bucket_t*> _segments[max_segments];
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _bucket_count;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _count;
+    pad_t<sizeof(_count)> _pad;
+
+    Hash _hash;
+    KeyEqual _eq;
+
+    static size_t segment_of(size_t bucket) noexcept {
+        size_t s = 0;
+        while (bucket) {
+            bucket >>= 1, ++s;
+        }
+        return s;
+    }
+
+    static size_t segment_size(size_t s) noexcept {
+        return s ? size_t(1) << (s - 1) : 1;
+    }
+
+    static size_t segment_base(size_t s) noexcept {
+        return s ? size_t(1) << (s - 1) : 0;
+    }
+
+    // nullptr if the segment could not be allocated
+    bucket_t* bucket_slot(size_t bucket) noexcept {
+        const size_t s = segment_of(bucket);
+        bucket_t* seg = _segments[s].load(std::memory_order_acquire);
+        UNLIKELY_IF(!seg) {
+            auto fresh = new (std::nothrow) bucket_t[segment_size(s)];
+            if (!fresh) {
+                return nullptr;
+            }
+            for (size_t i = 0; i < segment_size(s); ++i) {
+                fresh[i].store(nullptr, std::memory_order_relaxed);
+            }
+            if (_segments[s].compare_exchange_strong(seg, fresh,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                seg = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return &seg[bucket - segment_base(s)];
+    }
+
+    struct cursor {
+        std::atomic<uintptr_t>* prev;
+        node* cur;
+        uintptr_t next;
+    };
+
+    // Michael's search from a dummy node: cursor.cur is the first node not before (so_key, key),
+    // marked nodes on the way are unlinked. Returns true if cur holds key (or is the dummy for so_key).
+    // On return cur is protected by hp[hp_cur], the owner of prev by hp[hp_prev].
+    bool search(node* start, uint64_t so_key, const K* key, cursor& c, hazards_t& hp) noexcept {
+    try_again:
+        c.prev = &start->next;
+        c.cur = ptr_of(c.prev->load(std::memory_order_acquire));
+        for (;;) {
+            hp.protect(hp_cur, c.cur);
+            if (c.prev->load(std::memory_order_acquire) != raw_of(c.cur)) {
+                goto try_again;
+            }
+
+            if (!c.cur) {
+                return false;
+            }
+
+            c.next = c.cur->next.load(std::memory_order_acquire);
+            hp.protect(hp_next, ptr_of(c.next));
+            if (c.cur->next.load(std::memory_order_acquire) != c.next) {
+                goto try_again;
+            }
+
+            if (is_marked(c.next)) {
+                uintptr_t expected = raw_of(c.cur);
+                if (!c.prev->compare_exchange_strong(expected, c.next & ~mark_bit,
+                        std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    goto try_again;
+                }
+                retire(c.cur);
+                c.cur = ptr_of(c.next);
+                continue;
+            }
+
+            const uint64_t ck = c.cur->so_key;
+            if (ck > so_key) {
+                return false;
+            }
+
+            if (ck == so_key && (key ? !c.cur->is_dummy() && _eq(c.cur->key(), *key) : c.cur->is_dummy())) {
+                return true;
+            }
+
+            // cur becomes the owner of prev, it stays protected while next moves into hp_cur
+            hp.protect(hp_prev, c.cur);
+            c.prev = &c.cur->next;
+            c.cur = ptr_of(c.next);
+        }
+    }
+
+    // links n behind the dummy start unless an equal node exists, the existing one is returned then.
+    node* link(node* start, node* n, const K* key, hazards_t& hp) noexcept {
+        cursor c;
+        for (;;) {
+            if (search(start, n->so_key, key, c, hp)) {
+                return c.cur;
+            }
+
+            n->next.store(raw_of(c.cur), std::memory_order_relaxed);
+            uintptr_t expected = raw_of(c.cur);
+            if (c.prev->compare_exchange_strong(expected, raw_of(n),
+                    std::memory_order_release, std::memory_order_relaxed)) {
+                return n;
+            }
+        }
+    }
+
+    // dummies are never erased, so the returned node needs no hazard.
+    node* bucket_head(size_t bucket) noexcept {
+        bucket_t* slot = bucket_slot(bucket);
+        UNLIKELY_IF(!slot) {
+            return nullptr;
+        }
+
+        node* head = slot->load(std::memory_order_acquire);
+        LIKELY_IF(head) {
+            return head;
+        }
+
+        // the parent bucket is the same index without its highest bit, it already covers this range.
+        // Bucket 0 exists from the start, so this ends there at the latest.
+        node* start = bucket_head(bucket & ~segment_base(segment_of(bucket)));
+        UNLIKELY_IF(!start) {
+            return nullptr;
+        }
+
+        auto dummy = new (std::nothrow) node(chm_impl::dummy_key(bucket));
+        UNLIKELY_IF(!dummy) {
+            return nullptr;
+        }
+
+        hazards_t hp;
+        assert(hp.available() && "concurrent_hash_map: no hazard slots available");
+        node* linked = link(start, dummy, nullptr, hp);
+        hp.unprotect_all();
+        if (linked != dummy) {
+            delete dummy;
+        }
+
+        node* expected = nullptr;
+        slot->compare_exchange_strong(expected, linked, std::memory_order_acq_rel, std::memory_order_relaxed);
+        return linked;
+    }
+
+    node* head_for(uint64_t hash) noexcept {
+        const size_t mask = _bucket_count.load(std::memory_order_acquire) - 1;
+        return bucket_head(static_cast<size_t>(hash) & mask);
+    }
+
+    void grow_if_needed(size_t count) noexcept {
+        size_t buckets = _bucket_count.load(std::memory_order_relaxed);
+        if (count > buckets * max_load && segment_of(buckets) < max_segments) {
+            _bucket_count.compare_exchange_strong(buckets, buckets << 1,
+                std::memory_order_release, std::memory_order_relaxed);
+        }
+    }
+
+    // calls f(const node&) with the node for key protected, returns false if there is none.
+    template <typename F>
+    bool with_node(const K& key, F&& f) noexcept(noexcept(f(std::declval<const node&>()))) {
+        const uint64_t hash = _hash(key);
+        node* start = head_for(hash);
+        UNLIKELY_IF(!start) {
+            return false;
+        }
+
+        hazards_t hp;
+        assert(hp.available() && "concurrent_hash_map: no hazard slots available");
+        cursor c;
+        if (!search(start, chm_impl::regular_key(hash), &key, c, hp)) {
+            return false;
+        }
+        f(*c.cur);
+        return true;
+    }
+
+public:
+    // bucket_count is rounded up to a power of two
+    explicit concurrent_hash_map(size_t bucket_count = 16, const Hash& hash = Hash(), const KeyEqual& eq = KeyEqual())
+        : _bucket_count { 1 }
+        , _count { 0 }
+        , _hash(hash)
+        , _eq(eq) {
+        for (auto& s : _segments) {
+            s.store(nullptr, std::memory_order_relaxed);
+        }
+
+        size_t n = 1;
+        while (n < bucket_count) {
+            n <<= 1;
+        }
+        _bucket_count.store(n, std::memory_order_relaxed);
+
+        // bucket 0 starts the list, it must exist before anything else
+        auto slot = bucket_slot(0);
+        auto dummy = slot ? new (std::nothrow) node(chm_impl::dummy_key(0)) : nullptr;
+#if LFNDS_HAS_EXCEPTIONS
+        if (!dummy) {
+            throw std::bad_alloc();
+        }
+#else
+        assert(dummy && "concurrent_hash_map: failed to allocate the first bucket");
+#endif
+        slot->store(dummy, std::memory_order_relaxed);
+    }
+
+    // no other thread may use the map anymore
+    ~concurrent_hash_map() noexcept {
+        node* n = _segments[0].load(std::memory_order_relaxed)[0].load(std::memory_order_relaxed);
+        while (n) {
+            node* next = ptr_of(n->next.load(std::memory_order_relaxed));
+            delete_node(n);
+            n = next;
+        }
+
+        for (auto& s : _segments) {
+            delete[] s.load(std::memory_order_relaxed);
+        }
+    }
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    // false if key is already present (or no node could be allocated)
+    template <typename KK, typename... Args>
+    bool emplace(KK&& key, Args&&... args) {
+        auto n = new (std::nothrow) node(0, std::forward<KK>(key), std::forward<Args>(args)...);
+        UNLIKELY_IF(!n) {
+            return false;
+        }
+
+        const uint64_t hash = _hash(n->key());
+        n->so_key = chm_impl::regular_key(hash);
+        node* start = head_for(hash);
+        UNLIKELY_IF(!start) {
+            delete_node(n);
+            return false;
+        }
+
+        hazards_t hp;
+        assert(hp.available() && "concurrent_hash_map: no hazard slots available");
+        if (link(start, n, &n->key(), hp) != n) {
+            delete_node(n);
+            return false;
+        }
+
+        grow_if_needed(_count.fetch_add(1, std::memory_order_relaxed) + 1);
+        return true;
+    }
+
+    bool insert(const value_type& kv) {
+        return emplace(kv.first, kv.second);
+    }
+
+    bool insert(value_type&& kv) {
+        return emplace(std::move(const_cast<K&>(kv.first)), std::move(kv.second));
+    }
+
+    bool erase(const K& key) noexcept {
+        const uint64_t hash = _hash(key);
+        node* start = head_for(hash);
+        UNLIKELY_IF(!start) {
+            return false;
+        }
+
+        const uint64_t so_key = chm_impl::regular_key(hash);
+        hazards_t hp;
+        assert(hp.available() && "concurrent_hash_map: no hazard slots available");
+        cursor c;
+        for (;;) {
+            if (!search(start, so_key, &key, c, hp)) {
+                return false;
+            }
+
+            // logical removal first, whoever unlinks it retires it
+            if (!c.cur->next.compare_exchange_strong(c.next, c.next | mark_bit,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                continue;
+            }
+
+            uintptr_t expected = raw_of(c.cur);
+            if (c.prev->compare_exchange_strong(expected, c.next,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                retire(c.cur);
+            } else {
+                (void)search(start, so_key, &key, c, hp);
+            }
+            _count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    bool contains(const K& key) noexcept {
+        return with_node(key, [](const node&) noexcept {});
+    }
+
+    // a copy of the value for key, if any
+    inplace_t<V> find(const K& key) noexcept(std::is_nothrow_copy_constructible<V>::value) {
+        inplace_t<V> res;
+        with_node(key, [&res](const node& n) noexcept(std::is_nothrow_copy_constructible<V>::value) {
+            res.emplace(n.value());
+        });
+        return res;
+    }
+
+    // f(const V&) runs while the entry is protected, the value must not escape it.
+    template <typename F>
+    bool visit(const K& key, F&& f) noexcept(noexcept(f(std::declval<const V&>()))) {
+        return with_node(key, [&f](const node& n) noexcept(noexcept(f(std::declval<const V&>()))) {
+            f(n.value());
+        });
+    }
+
+    // approximations while other threads modify the map
+    size_t size() const noexcept {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_t bucket_count() const noexcept {
+        return _bucket_count.load(std::memory_order_relaxed);
+    }
+};
+}
+
+#endif
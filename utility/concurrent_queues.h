@@ -4,19 +4,24 @@
 #include <atomic>
 #include <thread>
 #include "../base/traits.h"
+#include "../base/sync_policy.h"
 #include "../memory/inplace_t.h"
 #include "yield.h"
 
 namespace lite_fnds {
-template <typename T, size_t capacity>
+// Policy: thread_safe_policy (default) or thread_local_policy when producer and consumer are the same thread.
+template <typename T, size_t capacity, typename Policy = thread_safe_policy>
 struct spsc_queue {
     static_assert(std::is_nothrow_move_constructible<T>::value, 
         "T must be nothrow move constructible");
     static_assert((capacity & (capacity - 1)) == 0, "capacity must be power of 2");
+    static_assert(is_sync_policy<Policy>::value, "Policy must be thread_safe_policy or thread_local_policy");
 
 protected:
-    struct alignas(CACHE_LINE_SIZE) slot_t {
-        std::atomic<uint32_t> ready;
+    using ready_t = policy_atomic_t<uint32_t, Policy>;
+
+    struct alignas(policy_alignment_v<Policy, ready_t, raw_inplace_storage_base<T>>) slot_t {
+        ready_t ready;
         raw_inplace_storage_base<T> storage;
 
         slot_t() noexcept : ready { 0 } { }
@@ -30,11 +35,8 @@ protected:
         }
     };
 
-    alignas(CACHE_LINE_SIZE) size_t _h { 0 };
-    pad_t<sizeof(_h)> _pad1;
-
-    alignas(CACHE_LINE_SIZE) size_t _t { 0 };
-    pad_t<sizeof(_t)> _pad2;
+    alignas(policy_alignment_v<Policy, size_t>) size_t _h { 0 };
+    alignas(policy_alignment_v<Policy, size_t>) size_t _t { 0 };
 
     slot_t _data[capacity];
 public:
@@ -0,0 +1,97 @@
+#ifndef LITE_FNDS_FUNCTION_REF_H
+#define LITE_FNDS_FUNCTION_REF_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "../base/traits.h"
+
+/**
+ * function_ref<R(Args...)>: a non-owning reference to a callable, for parameters which are
+ * only called during the call they are passed to.
+ *
+ * void for_each_item(function_ref<void(item&)> f);
+ * for_each_item([&](item& i) { total += i.size; });   // no allocation, no copy of the lambda
+ *
+ * Two pointers wide and trivially copyable. It does not extend the lifetime of the callable,
+ * use callable_wrapper for anything stored past the call (e.g. retire deleters).
+ */
+
+namespace lite_fnds {
+    template <typename>
+    class function_ref;
+
+    template <typename R, typename... Args>
+    class function_ref<R(Args...)> {
+        // an object or a function, a function pointer may not be cast to void*
+        union target_t {
+            void* obj;
+            void (*fn)();
+        };
+
+        using trampoline_t = R (*)(target_t, Args...);
+
+        target_t target_;
+        trampoline_t call_;
+
+        template <typename F>
+        static R call_object(target_t t, Args... args) {
+            return static_cast<R>((*static_cast<F*>(t.obj))(std::forward<Args>(args)...));
+        }
+
+        template <typename Fp>
+        static R call_function(target_t t, Args... args) {
+            return static_cast<R>(reinterpret_cast<Fp>(t.fn)(std::forward<Args>(args)...));
+        }
+
+        // like std::function, a void function_ref takes any result and drops it
+        template <typename F>
+        struct is_compatible {
+        private:
+            template <typename F_>
+            static auto test(int) -> disjunction<std::is_void<R>, std::is_convertible<invoke_result_t<F_&, Args...>, R>>;
+
+            template <typename...>
+            static auto test(...) -> std::false_type;
+
+        public:
+            static constexpr bool value = decltype(test<F>(0))::value;
+        };
+
+        template <typename F>
+        using is_fn_ptr = conjunction<std::is_pointer<F>, std::is_function<std::remove_pointer_t<F>>>;
+
+    public:
+        function_ref() = delete;
+
+        // references f, which must outlive every call through this function_ref
+        template <typename F, typename F_ = std::remove_reference_t<F>,
+            std::enable_if_t<conjunction_v<
+                negation<std::is_same<std::decay_t<F>, function_ref>>,
+                negation<std::is_function<F_>>,
+                negation<is_fn_ptr<std::decay_t<F>>>,
+                is_compatible<F_>>>* = nullptr>
+        function_ref(F&& f) noexcept
+            : call_ { &function_ref::call_object<F_> } {
+            target_.obj = const_cast<void*>(static_cast<const volatile void*>(std::addressof(f)));
+        }
+
+        // functions and function pointers are kept by value
+        template <typename F, typename Fp = std::decay_t<F>,
+            std::enable_if_t<conjunction_v<is_fn_ptr<Fp>, is_compatible<Fp>>>* = nullptr>
+        function_ref(F&& f) noexcept
+            : call_ { &function_ref::call_function<Fp> } {
+            target_.fn = reinterpret_cast<void (*)()>(static_cast<Fp>(f));
+        }
+
+        function_ref(const function_ref&) noexcept = default;
+        function_ref& operator=(const function_ref&) noexcept = default;
+
+        R operator()(Args... args) const {
+            return call_(target_, std::forward<Args>(args)...);
+        }
+    };
+}
+
+#endif
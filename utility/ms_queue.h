@@ -0,0 +1,241 @@
+#ifndef LITE_FNDS_MS_QUEUE_H
+#define LITE_FNDS_MS_QUEUE_H
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../base/traits.h"
+#include "../memory/hazard_ptr.h"
+#include "../memory/inplace_t.h"
+#include "static_list.h"
+#include "yield.h"
+
+/**
+ * Unbounded MPMC queue (Michael & Scott), no preset capacity.
+ *
+ * Dequeued nodes are retired through the hazard pointer Domain, once reclaimed they go back to a
+ * node pool shared by every queue of the same type, so a queue in steady state does not allocate.
+ * Emplace only fails if a node can neither be taken from the pool nor allocated.
+ */
+
+namespace lite_fnds {
+template <typename T, typename Domain = hp_mgr>
+struct ms_queue {
+    static_assert(conjunction_v<std::is_nothrow_move_constructible<T>, std::is_nothrow_destructible<T>>,
+        "T should be nothrow move constructible and nothrow destructible.");
+
+private:
+    struct node {
+        std::atomic<node*> next { nullptr };
+        raw_inplace_storage_base<T> storage;
+
+        T& data() noexcept {
+            return *storage.ptr();
+        }
+    };
+
+    // free nodes kept for reuse, anything beyond the capacity goes back to the heap.
+    static constexpr size_t pool_capacity = 1024;
+
+    struct node_pool {
+        static_list<node*, pool_capacity> free;
+
+        ~node_pool() noexcept {
+            for (auto n = free.pop(); n.has_value(); n = free.pop()) {
+                delete n.get();
+            }
+        }
+    };
+
+    static node_pool& pool() noexcept {
+        static node_pool p;
+        return p;
+    }
+
+    static node* make_node() noexcept {
+        auto n = pool().free.pop();
+        if (n.has_value()) {
+            auto p = n.get();
+            p->next.store(nullptr, std::memory_order_relaxed);
+            return p;
+        }
+        return new (std::nothrow) node();
+    }
+
+    static void recycle(node* n) noexcept {
+        if (!pool().free.emplace(n)) {
+            delete n;
+        }
+    }
+
+    static void retire(node* n) noexcept {
+        Domain::retire(n, [](node* p) noexcept {
+            recycle(p);
+        });
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<node*> _h;
+    pad_t<sizeof(_h)> _pad1;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<node*> _t;
+    pad_t<sizeof(_t)> _pad2;
+
+    // n already holds its value
+    void link(node* n) noexcept {
+        basic_hazard_ptr<Domain> hp;
+        assert(hp.available() && "ms_queue: no hazard slot available");
+        for (;; yield()) {
+            node* t = hp.acquire_protected(_t);
+            node* next = t->next.load(std::memory_order_acquire);
+            if (t != _t.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            // tail is lagging behind, help it forward
+            if (next) {
+                _t.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+
+            node* expected = nullptr;
+            if (t->next.compare_exchange_weak(expected, n, std::memory_order_release, std::memory_order_relaxed)) {
+                _t.compare_exchange_strong(t, n, std::memory_order_release, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+public:
+    using value_type = T;
+
+    // starts with an empty dummy node, the node behind _h always holds the front value.
+    ms_queue() {
+        auto dummy = make_node();
+#if LFNDS_HAS_EXCEPTIONS
+        if (!dummy) {
+            throw std::bad_alloc();
+        }
+#else
+        assert(dummy && "ms_queue: failed to allocate the dummy node");
+#endif
+        _h.store(dummy, std::memory_order_relaxed);
+        _t.store(dummy, std::memory_order_relaxed);
+    }
+
+    // no other thread may use the queue anymore
+    ~ms_queue() noexcept {
+        node* n = _h.load(std::memory_order_relaxed);
+        node* next = n->next.load(std::memory_order_relaxed);
+        recycle(n);
+        for (n = next; n; n = next) {
+            next = n->next.load(std::memory_order_relaxed);
+            n->storage.destroy();
+            recycle(n);
+        }
+    }
+
+    ms_queue(const ms_queue&) = delete;
+    ms_queue(ms_queue&&) = delete;
+    ms_queue& operator=(const ms_queue&) = delete;
+    ms_queue& operator=(ms_queue&&) = delete;
+
+    // fails only if no node could be allocated
+    bool try_emplace(T&& obj) noexcept {
+        auto n = make_node();
+        if (!n) {
+            return false;
+        }
+        n->storage.construct(std::move(obj));
+        link(n);
+        return true;
+    }
+
+    template <typename T_ = T, typename... Args,
+        std::enable_if_t<std::is_nothrow_constructible<T_, Args&&...>::value>* = nullptr>
+    bool try_emplace(Args&&... args) noexcept {
+        auto n = make_node();
+        if (!n) {
+            return false;
+        }
+        n->storage.construct(std::forward<Args>(args)...);
+        link(n);
+        return true;
+    }
+
+#if LFNDS_HAS_EXCEPTIONS
+    template <typename T_ = T, typename... Args,
+        std::enable_if_t<conjunction_v<
+            negation<std::is_nothrow_constructible<T_, Args&&...>>,
+            std::is_constructible<T_, Args&&...>>>* = nullptr>
+    bool try_emplace(Args&&... args) {
+        T tmp(std::forward<Args>(args)...);
+        return try_emplace(std::move(tmp));
+    }
+#endif
+
+    // retries until a node is available
+    template <typename... Args>
+    void wait_and_emplace(Args&&... args)
+        noexcept(noexcept(std::declval<ms_queue&>().try_emplace(std::forward<Args>(args)...))) {
+        while (!try_emplace(std::forward<Args>(args)...)) {
+            yield();
+        }
+    }
+
+    inplace_t<T> try_pop() noexcept {
+        inplace_t<T> res;
+        basic_hazard_array<Domain, 2> hp;
+        assert(hp.available() && "ms_queue: no hazard slot available");
+
+        for (;; yield()) {
+            node* h = hp.acquire_protected(0, _h);
+            node* t = _t.load(std::memory_order_acquire);
+            node* next = h->next.load(std::memory_order_acquire);
+            hp.protect(1, next);
+            // h is still the head, so next is still linked behind it and can't be retired yet
+            if (h != _h.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            if (!next) {
+                return res;
+            }
+
+            if (h == t) {
+                _t.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (_h.compare_exchange_weak(h, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                // next is the new dummy, its value belongs to the thread which moved the head
+                res.emplace(std::move(next->data()));
+                next->storage.destroy();
+                hp.unprotect_all();
+                retire(h);
+                return res;
+            }
+        }
+    }
+
+    T wait_and_pop() noexcept {
+        for (;; yield()) {
+            auto res = try_pop();
+            if (res.has_value()) {
+                return res.steal();
+            }
+        }
+    }
+
+    // only for approximating the queue is empty
+    bool empty() noexcept {
+        basic_hazard_ptr<Domain> hp;
+        assert(hp.available() && "ms_queue: no hazard slot available");
+        node* h = hp.acquire_protected(_h);
+        return !h->next.load(std::memory_order_acquire);
+    }
+};
+}
+
+#endif
@@ -7,12 +7,16 @@
 
 #include "../memory/inplace_t.h"
 #include "../base/traits.h"
+#include "../base/sync_policy.h"
 #include "yield.h"
 
 namespace lite_fnds {
-    template <typename T, size_t capacity>
+    template <typename T, size_t capacity, typename Policy = thread_safe_policy>
     struct static_list {
         using storage_t = std::decay_t<T>;
+        using policy_t = Policy;
+
+        static_assert(is_sync_policy<Policy>::value, "Policy must be thread_safe_policy or thread_local_policy.");
 
         static_assert(std::is_nothrow_move_constructible<T>::value,
                       "T must be no throw move constructible.");
@@ -23,7 +27,7 @@ namespace lite_fnds {
         struct node {
             raw_inplace_storage_base<storage_t> satellite;
 #ifdef TSAN_CLEAR
-            std::atomic<uint64_t> next;
+            policy_atomic_t<uint64_t, Policy> next;
 #else
             uint64_t next;
 #endif
@@ -53,15 +57,13 @@ namespace lite_fnds {
             return tag & offset_msk;
         }
 
-        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_;
-        pad_t<sizeof(head_)> _pad1;
-
-        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> free_;
-        pad_t<sizeof(free_)> _pad2;
+        using head_t = policy_atomic_t<uint64_t, Policy>;
 
-        node nodes[capacity];
+        alignas(policy_alignment_v<Policy, head_t>) head_t head_;
+        alignas(policy_alignment_v<Policy, head_t>) head_t free_;
+        alignas(policy_alignment_v<Policy, node>) node nodes[capacity];
 
-        uint64_t pop_from_list(std::atomic<uint64_t>& head) noexcept {
+        uint64_t pop_from_list(head_t& head) noexcept {
             uint64_t seq = 0, offset = 0;
             uint64_t h_ = head.load(std::memory_order_acquire);
             for (;;yield()) {
@@ -88,7 +90,7 @@ namespace lite_fnds {
             return make_seq(seq, offset);
         }
 
-        uint64_t append_to_list(std::atomic<uint64_t>& head, uint64_t fptr) noexcept {
+        uint64_t append_to_list(head_t& head, uint64_t fptr) noexcept {
             uint64_t h_ = head.load(std::memory_order_acquire);;
             for (;; yield()) {
 #ifdef TSAN_CLEAR